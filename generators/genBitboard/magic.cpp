@@ -3,7 +3,6 @@
 #include <fstream>
 
 #include <lib/chess/util.hpp>
-#include <lib/chess/ascii.hpp>
 #include <lib/lookuptables/bitboards.hpp>
 
 #include <generators/genBitboard/stringifyU64.hpp>
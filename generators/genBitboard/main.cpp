@@ -6,7 +6,6 @@
 #include <fstream>
 
 #include <lib/chess/util.hpp>
-#include <lib/chess/ascii.hpp>
 
 #include <generators/genBitboard/stringifyU64.hpp>
 
@@ -226,10 +225,6 @@ int main() {
     out << "    static constexpr U64 edge = " << "0x" << std::hex << std::setw(16) << std::setfill('0') << edge << ";\n";
     logger << "Generated center and edge bitboards";
 
-
-
-    logger << '\n' << Ascii::bitboardToAscii(pawn_pushes[54][BLACK]);
-
     out << '}';
     out.close();
 
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <lib/chess/util.hpp>
+#include <lib/lookuptables/bitboards.hpp>
+#include <lib/lookuptables/magicbitboards.hpp>
+
+namespace Chess::Attacks {
+    // bishop and rook rays (magic bitboard lookups), shared by the game state king attack test, the move generator and SEE
+    inline U64 genBishopRays(int position, U64 occupied_spaces) {
+        const int index = (((occupied_spaces & MagicBitboards::bishop_magic_relevant_squares_mask[position]) * MagicBitboards::bishop_magic_numbers[position]) >> (64 - MagicBitboards::bishop_magic_relevant_bits_count[position]));
+        return MagicBitboards::bishop_magic_bitboards[position][index];
+    }
+    inline U64 genRookRays(int position, U64 occupied_spaces) {
+        const int index = (((occupied_spaces & MagicBitboards::rook_magic_relevant_squares_mask[position]) * MagicBitboards::rook_magic_numbers[position]) >> (64 - MagicBitboards::rook_magic_relevant_bits_count[position]));
+        return MagicBitboards::rook_magic_bitboards[position][index];
+    }
+
+    inline U64 genPieceAttacks(int position, COLOR color, PIECE piece_type, U64 occupied_spaces) { // squares attacked by a single piece
+        switch (piece_type) {
+            case PAWN:   return Bitboards::pawn_attacks[position][color];
+            case KNIGHT: return Bitboards::knight_moves[position];
+            case BISHOP: return genBishopRays(position, occupied_spaces);
+            case ROOK:   return genRookRays(position, occupied_spaces);
+            case QUEEN:  return genBishopRays(position, occupied_spaces) | genRookRays(position, occupied_spaces);
+            case KING:   return Bitboards::king_moves[position];
+        }
+        return 0;
+    }
+
+    inline U64 genBetweenSquares(int a, int b) { // squares strictly between a and b if they share a rank, file or diagonal, otherwise 0
+        const U64 a_bb = squareToBitboard(a);
+        const U64 b_bb = squareToBitboard(b);
+        if (genRookRays(a, b_bb) & b_bb)   return genRookRays(a, b_bb) & genRookRays(b, a_bb);
+        if (genBishopRays(a, b_bb) & b_bb) return genBishopRays(a, b_bb) & genBishopRays(b, a_bb);
+        return 0;
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <utility>
+
+#include <lib/chess/util.hpp>
+#include <lib/chess/move.hpp>
+#include <lib/chess/attacks.hpp>
+#include <lib/lookuptables/zobristhashes.hpp>
+
+namespace Chess::Engine {
+
+// every reversible move (a non pawn piece moving between two squares it attacks on an empty board) keyed by the hash code change it makes,
+// piece on from ^ piece on to ^ side to move, the same key either direction. two positions whose hash codes differ by one of these keys
+// are a single move apart, which lets the search see a repetition one move before it happens (see ThreadData::hasUpcomingRepetition)
+// cuckoo hashing, every key sits in one of its 2 slots so a lookup is 2 probes
+struct CuckooTable {
+    static constexpr int SIZE = 8192; // 3668 reversible moves
+
+    U64 keys[SIZE];
+    Move moves[SIZE];
+
+    CuckooTable() {
+        for (int i = 0; i < SIZE; i++) {
+            keys[i] = 0;
+            moves[i] = Move();
+        }
+
+        int moves_c = 0;
+        for (int color = WHITE; color <= BLACK; color++) {
+            for (int piece = KNIGHT; piece <= KING; piece++) {
+                for (int from = 0; from < 64; from++) {
+                    for (int to = from + 1; to < 64; to++) {
+                        if (!(Attacks::genPieceAttacks(from, (COLOR) color, (PIECE) piece, 0) & squareToBitboard(to))) continue;
+
+                        Move move = Move(from, to, Move::NONE, false);
+                        U64 key = ZobristHashes::piece_codes[from][piece][color] ^ ZobristHashes::piece_codes[to][piece][color] ^ ZobristHashes::black_move_code;
+
+                        // insert, an occupied slot's entry gets kicked to its other slot until one lands in an empty slot
+                        int i = hash1(key);
+                        while (true) {
+                            std::swap(keys[i], key);
+                            std::swap(moves[i], move);
+                            if (move.v == 0) break;
+                            i = (i == hash1(key)) ? hash2(key) : hash1(key);
+                        }
+                        moves_c++;
+                    }
+                }
+            }
+        }
+        /* FOR DEBUG */ assert(moves_c == 3668);
+    }
+
+    inline Move find(U64 key) const { // the reversible move with this key, empty if there is none
+        int i = hash1(key);
+        if (keys[i] == key) return moves[i];
+        i = hash2(key);
+        if (keys[i] == key) return moves[i];
+        return Move();
+    }
+
+private:
+    static inline int hash1(U64 key) {
+        return key & (SIZE - 1);
+    }
+    static inline int hash2(U64 key) {
+        return (key >> 16) & (SIZE - 1);
+    }
+};
+static const CuckooTable cuckoo;
+}
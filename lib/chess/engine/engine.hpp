@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <thread>
 #include <atomic>
+#include <memory>
 
 #include <lib/chess/util.hpp>
 #include <lib/chess/gamestate.hpp>
@@ -11,6 +12,7 @@
 #include <lib/chess/unmove.hpp>
 
 #include <lib/chess/engine/negamax.hpp>
+#include <lib/chess/engine/threaddata.hpp>
 #include <lib/chess/engine/transpositiontable.hpp>
 
 namespace Chess::Engine {
@@ -22,6 +24,15 @@ public:
         int score;   // from side-to-move POV
     };
 
+    struct RootMove { // persists across iterations, the root move list is only generated once per search
+        Move move;
+        int score;          // from side-to-move POV, exact for the best move only, the others are upper bounds
+        int previous_score; // score of the previous iteration
+        long long nodes;    // nodes spent below this move on the last aspiration pass, how hard it was to refute
+        Move pv[MAX_PLY];   // principal variation starting with move, taken from the search stack whenever the move becomes the best
+        int pv_length;
+    };
+
 protected:
     GameState game_state; // should only be modified when the engine is not running
 
@@ -30,6 +41,9 @@ protected:
     U8 current_depth;
     
     TranspositionTable tt; 
+    std::unique_ptr<RootMove[]> root_moves; // [256] (heap allocated, every root move carries a full pv)
+    int root_moves_c = 0;
+    std::unique_ptr<ThreadData> thread_data; // search state of the worker thread (heap allocated, the history tables are large)
 
     // thread stuff
     std::atomic<bool> running_flag_in = false; // flag the engine object modifies to tell the worker flag when to start/stop
@@ -44,7 +58,9 @@ public:
         move_scores(),
         scores_c(0),
         current_depth(0),
-        tt(tt_size) {}
+        tt(tt_size),
+        root_moves(std::make_unique<RootMove[]>(256)),
+        thread_data(std::make_unique<ThreadData>()) {}
 
     void load_game_state(const GameState & gs) {
         assert(!running_flag_in && !running_flag_out); // ensure the engine is not running right now
@@ -68,111 +84,135 @@ public:
 
 
 protected:
-    static constexpr int ASP_WINDOW = 50; // start narrow; widen on fail
-
-
-    static inline void orderRootMoves(Move * moves, int n, const std::vector<int> & last_scores) {
-        // last_scores[i] corresponds to moves[i] from previous iteration
-        // fallback: if last_scores empty, do your normal order_moves(gs,...)
-        std::vector<int> idx(n); for (int i=0;i<n;++i) idx[i]=i;
-        std::stable_sort(idx.begin(), idx.end(), [&](int a, int b){
-            return last_scores[a] > last_scores[b];
-        });
-        // apply permutation in-place (small n, so simple cycle permute is fine)
-        for (int i=0;i<n;++i){
-            while (idx[i]!=i){
-                std::swap(moves[i], moves[idx[i]]);
-                std::swap(const_cast<int&>(last_scores[i]), const_cast<int&>(last_scores[idx[i]])); // if last_scores is non-const
-                std::swap(idx[i], idx[idx[i]]);
+    static constexpr int ASP_WINDOW = 50; // start narrow, doubles on every fail
+
+
+    // after an iteration: the best move first, then the rest by how many nodes it took to refute them on this iteration (more = closer to best)
+    // stable insertion sort, no allocation
+    void orderRootMoves(int best_i) {
+        std::rotate(root_moves.get(), root_moves.get() + best_i, root_moves.get() + best_i + 1);
+        for (int i = 2; i < root_moves_c; i++) {
+            const RootMove root_move = root_moves[i];
+            int j = i - 1;
+            while (j >= 1 && root_moves[j].nodes < root_move.nodes) {
+                root_moves[j + 1] = root_moves[j];
+                j--;
             }
+            root_moves[j + 1] = root_move;
         }
     }
 
-    
 public:
     // Iterative deepening driver
-    // Returns the final list of root moves with their depth-N scores (sorted best-first).
-    std::vector<MoveResult> evaluateAllMoves(GameState & root_gs, int maxDepth) {
+    // Returns the final list of root moves with their depth-N scores (sorted best-first), only the first score is exact, the rest are upper bounds.
+    // key_history is the hash codes of the positions played before root_gs (oldest first, see Game::getKeyHistory), needed to see repetitions that started before the root
+    std::vector<MoveResult> evaluateAllMoves(GameState & root_gs, int maxDepth, const std::vector<U64> & key_history = {}) {
         
-        Move root_moves[256];
+        Move moves[256];
         MoveGenerator::PreMoveData pre_move_data = MoveGenerator::genPreMoveData(root_gs);
-        int n = MoveGenerator::genAllMoves(root_gs, pre_move_data, root_moves);
+        const int n = MoveGenerator::genAllMoves(root_gs, pre_move_data, moves);
         if (n == 0) return {}; // stalemate/checkmate handled in negamax
 
-        // seed order once (captures first etc.)
-        orderMoves(root_gs, root_moves, n, Move());
+        thread_data->newSearch();
+        thread_data->game_keys = key_history;
+        thread_data->setStackKey(0, root_gs.getHashCode());
 
-        std::vector<int> last_scores(n, 0);  // scores from previous iteration
-        std::vector<int> curr_scores(n, 0);  // scores at current iteration
-
-        int last_best_score = 0;
+        // seed order once (captures first etc.)
+        orderMoves(root_gs, moves, n, Move());
+        root_moves_c = n;
+        for (int i = 0; i < n; i++) root_moves[i] = RootMove {moves[i], -EVAL_INF, -EVAL_INF, 0, {moves[i]}, 1};
 
         for (int depth = 1; depth <= maxDepth; ++depth) {
-            if (depth > 1) {
-                // Stable reorder rootMoves by lastScores (higher first)
-                std::vector<int> tmp_last = last_scores; // copy because orderRootMoves mutates
-                orderRootMoves(root_moves, n, tmp_last);
-            }
+            for (int i = 0; i < n; i++) root_moves[i].previous_score = root_moves[i].score;
 
-            // Aspiration window around last best score
+            // aspiration window around the previous iteration's score, when the search falls outside it the window is widened
+            // (exponentially, failing side only) and the whole iteration is searched again
+            int delta = ASP_WINDOW;
             int alpha0 = -EVAL_INF, beta0 = EVAL_INF;
             if (depth > 1) {
-                alpha0 = last_best_score - ASP_WINDOW;
-                beta0  = last_best_score + ASP_WINDOW;
+                alpha0 = std::max(root_moves[0].previous_score - delta, (int) -EVAL_INF);
+                beta0  = std::min(root_moves[0].previous_score + delta, (int) EVAL_INF);
             }
 
-            const int ORIG_ALPHA = alpha0;
-            int best_score = -EVAL_INF;
-            Move best_move;
-
-            // Search all root moves
-            for (int i = 0; i < n; ++i) {
-                Move move = root_moves[i];
-                Unmove u = root_gs.applyMove(move);
-
-                // PVS at root
-                int score = -negamax(root_gs, tt, depth - 1, -beta0, -alpha0, 1);
-
-                // Aspiration fail: re-search with full window
-                if (score <= alpha0 || score >= beta0) {
-                    score = -negamax(root_gs, tt, depth - 1, -EVAL_INF, EVAL_INF, 1);
+            int best_score;
+            int best_i;
+            while (true) {
+                int alpha = alpha0;
+                best_i = 0;
+                best_score = -EVAL_INF;
+                for (int i = 0; i < n; i++) root_moves[i].nodes = 0; // only the last pass counts, moves searched again after a fail would look harder to refute
+
+                // Search all root moves, PVS: the first move gets the full window, the rest a zero window scout
+                // only the best move ends up with an exact score, the others are upper bounds
+                for (int i = 0; i < n; ++i) {
+                    RootMove & root_move = root_moves[i];
+                    const long long nodes_before = thread_data->nodes;
+                    thread_data->setStackMove(0, root_gs, root_move.move);
+                    Unmove u = root_gs.applyMove(root_move.move);
+
+                    int score;
+                    if (i == 0) {
+                        score = -negamax(root_gs, tt, *thread_data, depth - 1, -beta0, -alpha, 1);
+                    } else {
+                        score = -negamax(root_gs, tt, *thread_data, depth - 1, -alpha - 1, -alpha, 1);
+                        if (score > alpha && score < beta0) score = -negamax(root_gs, tt, *thread_data, depth - 1, -beta0, -alpha, 1);
+                    }
+
+                    root_gs.applyUnmove(u);
+
+                    root_move.score = score;
+                    root_move.nodes += thread_data->nodes - nodes_before;
+
+                    if (i == 0 || score > alpha) {
+                        thread_data->updatePV(0, root_move.move);
+                        const ThreadData::StackEntry & root_entry = thread_data->stackEntry(0);
+                        std::copy(root_entry.pv, root_entry.pv + root_entry.pv_length, root_move.pv);
+                        root_move.pv_length = root_entry.pv_length;
+                    }
+
+                    if (score > best_score) {
+                        best_score = score;
+                        best_i = i;
+                    }
+                    if (score > alpha) {
+                        alpha = score;
+                        if (alpha >= beta0) break;
+                    }
                 }
 
-                root_gs.applyUnmove(u);
-
-                curr_scores[i] = score;
-
-                if (score > best_score) {
-                    best_score = score;
-                    best_move = move;
+                if (best_score <= alpha0) { // fail low, every move is an upper bound
+                    alpha0 = std::max(best_score - delta, (int) -EVAL_INF);
                 }
-                if (score > alpha0) {
-                    alpha0 = score;
-                    if (alpha0 >= beta0) break;
+                else if (best_score >= beta0) { // fail high, the move that got there is searched first on the re-search
+                    beta0 = std::min(best_score + delta, (int) EVAL_INF);
+                    std::rotate(root_moves.get(), root_moves.get() + best_i, root_moves.get() + best_i + 1);
                 }
+                else break;
+
+                delta *= 2;
             }
 
-            // store results to TT
-            TranspositionTable::Node::Type bound;
-            if (best_score <= ORIG_ALPHA) bound = TranspositionTable::Node::UPPERBOUND; // fail-low
-            else if (best_score >= beta0) bound = TranspositionTable::Node::LOWERBOUND; // fail-high
-            else                          bound = TranspositionTable::Node::EXACT;      // PV node
-            tt.add_entry(root_gs.getHashCode(), best_move, best_score, depth, bound);
+            // store results to TT - the iteration only ends once the score lands inside the window, so it is exact
+            tt.add_entry(root_gs.getHashCode(), root_moves[best_i].move, best_score, depth, TranspositionTable::Node::EXACT);
 
             // Prepare for next iteration
-            last_best_score = best_score;
-            last_scores = curr_scores;
+            orderRootMoves(best_i);
             tt.bump_generation();
         }
 
         // Build result vector sorted by final scores
         std::vector<MoveResult> out;
         out.reserve(n);
-        for (int i=0;i<n;++i) out.emplace_back(MoveResult {root_moves[i], last_scores[i]});
+        for (int i=0;i<n;++i) out.emplace_back(MoveResult {root_moves[i].move, root_moves[i].score});
         std::stable_sort(out.begin(), out.end(),
             [](auto& a, auto& b){ return a.score > b.score; });
         return out;
     }
 
+    std::vector<Move> getPrincipalVariation() const { // of the last search
+        if (root_moves_c == 0) return {};
+        return std::vector<Move>(root_moves[0].pv, root_moves[0].pv + root_moves[0].pv_length);
+    }
+
 };
 }
\ No newline at end of file
@@ -0,0 +1,308 @@
+#pragma once
+
+#include <algorithm>
+
+#include <lib/chess/util.hpp>
+#include <lib/chess/gamestate.hpp>
+#include <lib/chess/move.hpp>
+#include <lib/chess/movegenerator.hpp>
+
+#include <lib/chess/engine/staticexchange.hpp>
+#include <lib/chess/engine/threaddata.hpp>
+
+namespace Chess::Engine {
+
+    static const int mvv_lva[6][6] = {
+        // Attacker:  PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING
+        {105, 104, 103, 102, 101, 100}, // Victim PAWN
+        {205, 204, 203, 202, 201, 200}, // Victim KNIGHT
+        {305, 304, 303, 302, 301, 300}, // Victim BISHOP
+        {405, 404, 403, 402, 401, 400}, // Victim ROOK
+        {505, 504, 503, 502, 501, 500}, // Victim QUEEN
+        {605, 604, 603, 602, 601, 600}  // Victim KING
+    };
+
+// hands out the moves of a node one at a time in stages, each stage is only generated once the previous one runs dry
+// so a cutoff on the tt move or a capture never pays for the quiet move generation
+// main search: tt move -> winning captures -> killers & countermove -> quiets -> losing captures
+// quiescence:  winning captures -> quiet checks (first qsearch ply only), losing captures are dropped
+// probcut:     captures that win at least a given SEE threshold, tt move first
+class MovePicker {
+public:
+    enum Stage {
+        TT_MOVE, GEN_CAPTURES, GOOD_CAPTURES, REFUTATIONS, GEN_QUIETS, QUIETS, BAD_CAPTURES,
+        QS_TT_MOVE, QS_GEN_CAPTURES, QS_CAPTURES, QS_GEN_QUIET_CHECKS, QS_QUIET_CHECKS,
+        PROBCUT_TT_MOVE, PROBCUT_GEN_CAPTURES, PROBCUT_CAPTURES,
+        DONE
+    };
+
+private:
+    const GameState & gs;
+    const MoveGenerator::PreMoveData & pre_move_data;
+    const bool pseudo_legal; // moves come from genPseudoLegalMoves, the caller checks each one once it's made
+    const ThreadData & thread_data; // history tables for ordering
+    const int ply;
+
+    Stage stage;
+    Move tt_move;
+    Move refutations[3]; // killer 1, killer 2, countermove
+    int refutations_i = 0;
+    bool gen_quiet_checks = false;
+    bool skip_quiets = false;
+    int see_threshold = 0; // probcut only
+
+    Move * moves; // storage comes from the search stack (ThreadData::MoveList), a picker is too big to keep on the recursion stack
+    int * scores;
+    int cur = 0; // next move of the current stage
+    int end = 0; // end of the current stage
+    int end_bad_captures = 0; // losing captures are moved to the front of the list as the good ones are picked, cur never falls behind this
+
+public:
+    // main search (and quiescence in check)
+    MovePicker(const GameState & _gs, const MoveGenerator::PreMoveData & _pre_move_data, bool _pseudo_legal, Move _tt_move, const ThreadData & _thread_data, int _ply, ThreadData::MoveList & _move_list):
+        gs(_gs),
+        pre_move_data(_pre_move_data),
+        pseudo_legal(_pseudo_legal),
+        thread_data(_thread_data),
+        ply(_ply),
+        stage(TT_MOVE),
+        tt_move(isValidMove(_tt_move) ? _tt_move : Move()),
+        moves(_move_list.moves),
+        scores(_move_list.scores)
+    {
+        if (_ply < MAX_PLY) {
+            refutations[0] = _thread_data.stackEntry(_ply).killers[0];
+            refutations[1] = _thread_data.stackEntry(_ply).killers[1];
+        }
+        refutations[2] = _thread_data.getCounterMove(_ply);
+    }
+
+    // quiescence search, only valid when not in check (in check every evasion is searched, use the main search constructor)
+    MovePicker(const GameState & _gs, const MoveGenerator::PreMoveData & _pre_move_data, bool _pseudo_legal, Move _tt_move, const ThreadData & _thread_data, int _ply, ThreadData::MoveList & _move_list, bool _gen_quiet_checks):
+        gs(_gs),
+        pre_move_data(_pre_move_data),
+        pseudo_legal(_pseudo_legal),
+        thread_data(_thread_data),
+        ply(_ply),
+        stage(QS_TT_MOVE),
+        tt_move(_tt_move.isCapture() && isValidMove(_tt_move) && StaticExchange::see(_gs, _tt_move, 0) ? _tt_move : Move()),
+        gen_quiet_checks(_gen_quiet_checks),
+        moves(_move_list.moves),
+        scores(_move_list.scores)
+    {
+        /* FOR DEBUG */ assert(!_pre_move_data.isCheck());
+    }
+
+    // probcut, captures with SEE >= see_threshold only (the threshold comes before thread data to keep it apart from the main search constructor)
+    MovePicker(const GameState & _gs, const MoveGenerator::PreMoveData & _pre_move_data, bool _pseudo_legal, Move _tt_move, int _see_threshold, const ThreadData & _thread_data, int _ply, ThreadData::MoveList & _move_list):
+        gs(_gs),
+        pre_move_data(_pre_move_data),
+        pseudo_legal(_pseudo_legal),
+        thread_data(_thread_data),
+        ply(_ply),
+        stage(PROBCUT_TT_MOVE),
+        tt_move(_tt_move.isCapture() && isValidMove(_tt_move) && StaticExchange::see(_gs, _tt_move, _see_threshold) ? _tt_move : Move()),
+        see_threshold(_see_threshold),
+        moves(_move_list.moves),
+        scores(_move_list.scores)
+    {
+        /* FOR DEBUG */ assert(!_pre_move_data.isCheck());
+    }
+
+    inline void skipQuiets() { // the rest of the quiets (killers & countermove included) are never generated or handed out, captures still are
+        skip_quiets = true;
+    }
+
+    Move next() { // returns an empty move once every stage is exhausted
+        switch (stage) {
+            case TT_MOVE:
+                stage = GEN_CAPTURES;
+                if (tt_move.v != 0) return tt_move;
+                [[fallthrough]];
+
+            case GEN_CAPTURES:
+                cur = end_bad_captures = 0;
+                end = genMoves(moves, MoveGenerator::CAPTURES);
+                scoreCaptures();
+                stage = GOOD_CAPTURES;
+                [[fallthrough]];
+
+            case GOOD_CAPTURES:
+                while (cur < end) {
+                    selectBest();
+                    const Move move = moves[cur++];
+                    if (move.v == tt_move.v) continue;
+                    if (!StaticExchange::see(gs, move, 0)) { // save it for after the quiets
+                        moves[end_bad_captures++] = move;
+                        continue;
+                    }
+                    return move;
+                }
+                stage = REFUTATIONS;
+                [[fallthrough]];
+
+            case REFUTATIONS:
+                while (refutations_i < 3 && !skip_quiets) {
+                    Move & move = refutations[refutations_i];
+                    if (move.v == tt_move.v || move.isCapture() || isEarlierRefutation(move) || !isValidMove(move)) {
+                        move = Move(); // not searched here, so the quiets stage must not skip it
+                        refutations_i++;
+                        continue;
+                    }
+                    refutations_i++;
+                    return move;
+                }
+                stage = GEN_QUIETS;
+                [[fallthrough]];
+
+            case GEN_QUIETS:
+                cur = end;
+                if (!skip_quiets) {
+                    end = cur + genMoves(moves + cur, MoveGenerator::QUIETS);
+                    scoreQuiets();
+                    sortQuiets();
+                }
+                stage = QUIETS;
+                [[fallthrough]];
+
+            case QUIETS:
+                while (cur < end && !skip_quiets) {
+                    const Move move = moves[cur++];
+                    if (move.v == tt_move.v || move.v == refutations[0].v || move.v == refutations[1].v || move.v == refutations[2].v) continue;
+                    return move;
+                }
+                cur = 0;
+                end = end_bad_captures;
+                stage = BAD_CAPTURES;
+                [[fallthrough]];
+
+            case BAD_CAPTURES:
+                if (cur < end) return moves[cur++];
+                stage = DONE;
+                return Move();
+
+
+            case QS_TT_MOVE:
+                stage = QS_GEN_CAPTURES;
+                if (tt_move.v != 0) return tt_move;
+                [[fallthrough]];
+
+            case QS_GEN_CAPTURES:
+                cur = 0;
+                end = genMoves(moves, MoveGenerator::CAPTURES);
+                scoreCaptures();
+                stage = QS_CAPTURES;
+                [[fallthrough]];
+
+            case QS_CAPTURES:
+                while (cur < end) {
+                    selectBest();
+                    const Move move = moves[cur++];
+                    if (move.v == tt_move.v || !StaticExchange::see(gs, move, 0)) continue; // losing captures are not worth a qsearch node
+                    return move;
+                }
+                if (!gen_quiet_checks) {
+                    stage = DONE;
+                    return Move();
+                }
+                stage = QS_GEN_QUIET_CHECKS;
+                [[fallthrough]];
+
+            case QS_GEN_QUIET_CHECKS:
+                cur = 0;
+                end = MoveGenerator::genQuietChecks(gs, pre_move_data, MoveGenerator::genCheckInfo(gs), moves);
+                stage = QS_QUIET_CHECKS;
+                [[fallthrough]];
+
+            case QS_QUIET_CHECKS:
+                while (cur < end) {
+                    const Move move = moves[cur++];
+                    if (!StaticExchange::see(gs, move, 0)) continue; // checking piece just gets taken
+                    return move;
+                }
+                stage = DONE;
+                return Move();
+
+            case PROBCUT_TT_MOVE:
+                stage = PROBCUT_GEN_CAPTURES;
+                if (tt_move.v != 0) return tt_move;
+                [[fallthrough]];
+
+            case PROBCUT_GEN_CAPTURES:
+                cur = 0;
+                end = genMoves(moves, MoveGenerator::CAPTURES);
+                scoreCaptures();
+                stage = PROBCUT_CAPTURES;
+                [[fallthrough]];
+
+            case PROBCUT_CAPTURES:
+                while (cur < end) {
+                    selectBest();
+                    const Move move = moves[cur++];
+                    if (move.v == tt_move.v || !StaticExchange::see(gs, move, see_threshold)) continue;
+                    return move;
+                }
+                stage = DONE;
+                [[fallthrough]];
+
+            case DONE:
+                return Move();
+        }
+        return Move();
+    }
+
+private:
+    inline unsigned int genMoves(Move * moves_v, MoveGenerator::GEN_TYPE gen_type) {
+        if (pseudo_legal) return MoveGenerator::genPseudoLegalMoves(gs, pre_move_data, moves_v, gen_type);
+        return MoveGenerator::genAllMoves(gs, pre_move_data, moves_v, gen_type);
+    }
+
+    inline bool isValidMove(const Move & move) const { // moves from outside the generator (tt, killers) can come from another position
+        return move.v != 0 && MoveGenerator::isPseudoLegal(gs, move) && (pseudo_legal || MoveGenerator::isLegal(gs, move, pre_move_data));
+    }
+
+    inline bool isEarlierRefutation(const Move & move) const {
+        for (int i = 0; i < refutations_i; i++) {
+            if (refutations[i].v == move.v) return true;
+        }
+        return false;
+    }
+
+    inline void scoreCaptures() {
+        for (int i = cur; i < end; i++) {
+            const PIECE victim = gs.isMoveEnPassant(moves[i]) ? PAWN : gs.getPieceTypeAtSquare(moves[i].to(), (COLOR) !gs.turn);
+            const PIECE attacker = gs.getPieceTypeAtSquare(moves[i].from(), gs.turn);
+            scores[i] = mvv_lva[victim][attacker] * 16 + thread_data.getCaptureHistory(gs.turn, attacker, moves[i].to(), victim) / 8; // history can reorder within about one victim class
+        }
+    }
+    inline void scoreQuiets() {
+        for (int i = cur; i < end; i++) {
+            scores[i] = thread_data.getQuietHistory(ply, gs.turn, gs.getPieceTypeAtSquare(moves[i].from(), gs.turn), moves[i]);
+            if (moves[i].promo_piece() == QUEEN) scores[i] += 4 * ThreadData::HISTORY_MAX; // queen promotions first, under promotions are almost never best
+        }
+    }
+
+    inline void selectBest() { // swap the highest scored move left in the stage to cur, captures are few and usually cut early so this beats a full sort
+        int best = cur;
+        for (int i = cur + 1; i < end; i++) {
+            if (scores[i] > scores[best]) best = i;
+        }
+        std::swap(moves[cur], moves[best]);
+        std::swap(scores[cur], scores[best]);
+    }
+    inline void sortQuiets() { // stable insertion sort, higher score = earlier
+        for (int i = cur + 1; i < end; i++) {
+            const Move move = moves[i];
+            const int score = scores[i];
+            int j = i - 1;
+            while (j >= cur && scores[j] < score) {
+                moves[j + 1] = moves[j];
+                scores[j + 1] = scores[j];
+                j--;
+            }
+            moves[j + 1] = move;
+            scores[j + 1] = score;
+        }
+    }
+};
+}
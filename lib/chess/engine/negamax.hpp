@@ -1,6 +1,7 @@
 #pragma once
 
 #include <algorithm>
+#include <cmath>
 
 #include <lib/chess/util.hpp>
 #include <lib/chess/gamestate.hpp>
@@ -8,34 +9,40 @@
 #include <lib/chess/movegenerator.hpp>
 #include <lib/chess/unmove.hpp>
 
+#include <lib/chess/engine/movepicker.hpp>
 #include <lib/chess/engine/staticevaluation.hpp>
+#include <lib/chess/engine/staticexchange.hpp>
+#include <lib/chess/engine/threaddata.hpp>
 #include <lib/chess/engine/transpositiontable.hpp>
 
 namespace Chess::Engine::Negamax {
 
-    static const int mvv_lva[6][6] = {
-        // Attacker:  PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING
-        {105, 205, 305, 405, 505, 605}, // Victim PAWN
-        {104, 204, 304, 404, 504, 604}, // Victim KNIGHT
-        {103, 203, 303, 403, 503, 603}, // Victim BISHOP
-        {102, 202, 302, 402, 502, 602}, // Victim ROOK
-        {101, 201, 301, 401, 501, 601}, // Victim QUEEN
-        {100, 200, 300, 400, 500, 600}  // Victim KING
-    };
     int captureScore(const GameState & gs, const Move & m, const Move & best_move) {
         if (!m.isCapture()) return 0;
         if (m.v == best_move.v) return 1024;
         // Map CAPTURE enum to piece index (0 = PAWN, ..., 5 = KING)
         int victim = static_cast<int>(gs.isMoveEnPassant(m) ? PAWN : gs.getPieceTypeAtSquare(m.to(), (COLOR) !gs.turn));
         int attacker = static_cast<int>(gs.getPieceTypeAtSquare(m.from(), gs.turn));
+        if (!StaticExchange::see(gs, m, 0)) return mvv_lva[victim][attacker] - 1024; // losing captures go after the quiet moves
         return mvv_lva[victim][attacker];
     }
     void orderMoves(const GameState & gs, Move * moves, int moves_c, const Move & best_move) {
-        std::sort(moves, moves + moves_c, [gs, best_move](const Move & a, const Move & b) {
-            int sa = captureScore(gs, a, best_move);
-            int sb = captureScore(gs, b, best_move);
-            return sa > sb; // higher score = earlier
-        });
+        // score every move once (SEE is too expensive to redo per comparison), then stable insertion sort, higher score = earlier
+        int scores[256];
+        for (int i = 0; i < moves_c; i++) scores[i] = captureScore(gs, moves[i], best_move);
+
+        for (int i = 1; i < moves_c; i++) {
+            const Move move = moves[i];
+            const int score = scores[i];
+            int j = i - 1;
+            while (j >= 0 && scores[j] < score) {
+                moves[j + 1] = moves[j];
+                scores[j + 1] = scores[j];
+                j--;
+            }
+            moves[j + 1] = move;
+            scores[j + 1] = score;
+        }
     }
     
     constexpr I16 EVAL_INF = 30000;
@@ -43,22 +50,145 @@ namespace Chess::Engine::Negamax {
     constexpr I16 MATE_THRESHOLD = MATE - 2048;
 
 
+    // move generation used by the search - PSEUDO_LEGAL skips pin detection and checks each move once it's made (see MoveGenerator::genPseudoLegalMoves)
+    enum class GenerationMode { LEGAL, PSEUDO_LEGAL };
+    static GenerationMode generation_mode = GenerationMode::LEGAL;
+
+    inline MoveGenerator::PreMoveData genSearchPreMoveData(const GameState & gs) {
+        return MoveGenerator::genPreMoveData(gs, generation_mode == GenerationMode::LEGAL);
+    }
+    inline bool isSearchMoveLegal(const GameState & gs) { // after applyMove - generated moves are already legal in LEGAL mode
+        return generation_mode == GenerationMode::LEGAL || MoveGenerator::isLegalAfterMove(gs);
+    }
+
+    inline int evaluate(const GameState & gs, const MoveGenerator::PreMoveData & pre_move_data) { // side to move pov, full window so the lazy eval never cuts it short
+        const int eval = StaticEvaluation::staticEvaluation(gs, pre_move_data, -EVAL_INF, EVAL_INF);
+        return gs.turn == WHITE ? eval : -eval;
+    }
+
+    // mate scores are stored in the tt as distance from the node instead of from the root, a transposition can reach the node at another ply
+    inline int scoreToTT(int score, int ply) {
+        if (score >  MATE_THRESHOLD) return score + ply;
+        if (score < -MATE_THRESHOLD) return score - ply;
+        return score;
+    }
+    inline int scoreFromTT(int score, int ply) {
+        if (score >  MATE_THRESHOLD) return score - ply;
+        if (score < -MATE_THRESHOLD) return score + ply;
+        return score;
+    }
+
+    inline int evaluateAtMaxPly(const GameState & gs, ThreadData & td) { // out of search stack, the pre move data goes in the spare entry so it takes no room in the node frames
+        MoveGenerator::PreMoveData & pre_move_data = td.stackEntry(MAX_PLY).pre_move_data;
+        pre_move_data = genSearchPreMoveData(gs);
+        return evaluate(gs, pre_move_data);
+    }
+
+    inline bool hasNonPawnMaterial(const GameState & gs, COLOR color) { // with only king & pawns zugzwang is common and null move results can't be trusted
+        return gs.occupied_spaces_color[color] & ~(gs.pieces[color][PAWN] | gs.pieces[color][KING]);
+    }
+
+    // late move reductions - reductions[depth][move number] = 0.75 + ln(depth) * ln(move number) / 2.25
+    struct ReductionTable {
+        int table[64][64];
+
+        ReductionTable() {
+            for (int depth = 0; depth < 64; depth++) {
+                for (int moves_c = 0; moves_c < 64; moves_c++) {
+                    table[depth][moves_c] = (depth == 0 || moves_c == 0) ? 0 : (int) (0.75 + std::log(depth) * std::log(moves_c) / 2.25);
+                }
+            }
+        }
+        inline int get(int depth, int moves_c) const {
+            return table[std::min(depth, 63)][std::min(moves_c, 63)];
+        }
+    };
+    static const ReductionTable reductions;
+    constexpr int LMR_MIN_DEPTH = 3;
+    constexpr int LMR_HISTORY_DIVISOR = 8192; // every LMR_HISTORY_DIVISOR of quiet history is one ply less (or more) reduction
+
+    // static eval pruning, margins are in StaticEvaluation
+    constexpr int RFP_MAX_DEPTH = 7;
+    constexpr int RAZOR_MAX_DEPTH = 3;
+    constexpr int FUTILITY_MAX_DEPTH = 6;
+
+    // move count based pruning
+    constexpr int LMP_MAX_DEPTH = 8;
+    constexpr int HISTORY_PRUNING_MAX_DEPTH = 4;
+    constexpr int HISTORY_PRUNING_MARGIN = 4096; // per ply, quiets with a combined history below -margin * depth are skipped
+    inline int lateMovePruningCount(int depth, bool improving) { // quiets tried before the rest are skipped
+        return (3 + depth * depth) / (improving ? 1 : 2);
+    }
+
+    // extensions
+    constexpr int EXTENSION_BUDGET = 10; // most plies of extension on one path, stops forcing lines (perpetual checks) from exploding
+    constexpr int SINGULAR_MIN_DEPTH = 8;
+    constexpr int SINGULAR_MARGIN = 2; // per ply, how far below the tt score every other move must fail for the tt move to count as singular
+
+    // what to do at a node with no tt move to try first - move ordering falls back to mvv_lva & history, which is poor at high depth
+    // REDUCTION (iir) searches it one ply shallower, the next iteration finds a tt move there and searches it properly
+    // DEEPENING (iid) runs a shallower search of the node first just to get a tt move out of it
+    enum class IIDPolicy { NONE, REDUCTION, DEEPENING };
+    static IIDPolicy iid_policy = IIDPolicy::REDUCTION;
+    constexpr int IIR_MIN_DEPTH = 4;
+    constexpr int IIR_MIN_DEPTH_NON_PV = 6; // most non pv nodes without a tt move are new cut nodes, shallow ones are cheap enough to search as is
+    constexpr int IID_MIN_DEPTH = 5; // pv nodes, depth - 2
+    constexpr int IID_MIN_DEPTH_NON_PV = 8; // depth / 2, only worth it when the subtree is large
+
+    // probcut, margin is in StaticEvaluation
+    constexpr int PROBCUT_MIN_DEPTH = 5;
+    constexpr int PROBCUT_REDUCTION = 4;
+
+    // null move pruning
+    constexpr int NMP_MIN_DEPTH = 3;
+    constexpr int NMP_VERIFICATION_DEPTH = 12; // from this depth a null move cutoff is only trusted once a verification search agrees
+
     // temp counters
     static int qcnt = 0;
     static int ncnt = 0;
     static int tthit = 0;
     static int ttcut = 0;
+    static int betacut = 0;
+    static int firstcut = 0;
+
+    inline PIECE capturedPiece(const GameState & gs, const Move & move) { // before the move is applied
+        return gs.isMoveEnPassant(move) ? PAWN : gs.getPieceTypeAtSquare(move.to(), (COLOR) !gs.turn);
+    }
+
+    // best_move caused a beta cutoff, reward it and punish the moves searched before it
+    void updateCutoffStats(const GameState & gs, ThreadData & td, const Move & best_move, const Move * quiets_searched, int quiets_searched_c, const Move * captures_searched, int captures_searched_c, int depth, int ply) {
+        const int bonus = ThreadData::historyBonus(depth);
+
+        if (!best_move.isCapture()) {
+            td.storeKiller(ply, best_move);
+            td.storeCounterMove(ply, best_move);
+
+            td.updateQuietHistory(ply, gs.turn, gs.getPieceTypeAtSquare(best_move.from(), gs.turn), best_move, bonus);
+            for (int i = 0; i < quiets_searched_c; i++) {
+                td.updateQuietHistory(ply, gs.turn, gs.getPieceTypeAtSquare(quiets_searched[i].from(), gs.turn), quiets_searched[i], -bonus);
+            }
+        }
+        else {
+            td.updateCaptureHistory(gs.turn, gs.getPieceTypeAtSquare(best_move.from(), gs.turn), best_move.to(), capturedPiece(gs, best_move), bonus);
+        }
 
-    int quiescence(GameState & gs, TranspositionTable & tt, int alpha, int beta, int ply) {
+        for (int i = 0; i < captures_searched_c; i++) { // captures that didn't cut are punished either way
+            td.updateCaptureHistory(gs.turn, gs.getPieceTypeAtSquare(captures_searched[i].from(), gs.turn), captures_searched[i].to(), capturedPiece(gs, captures_searched[i]), -bonus);
+        }
+    }
+
+    int quiescence(GameState & gs, TranspositionTable & tt, ThreadData & td, int alpha, int beta, int ply, int qdepth = 0) {
         /* temp */ qcnt++;
+        td.nodes++;
+
+        if (ply >= MAX_PLY) return evaluateAtMaxPly(gs, td);
+        td.clearPV(ply);
 
         // transposition table hit check
         TranspositionTable::Node hit = tt.findNode(gs.getHashCode());
         if (hit.is_valid()) {
             tthit++;
-            int hit_score = hit.score;
-            if (hit_score >  MATE_THRESHOLD) hit_score -= ply;   // convert back to node-local POV
-            if (hit_score < -MATE_THRESHOLD) hit_score += ply;
+            const int hit_score = scoreFromTT(hit.score, ply);
 
             switch (hit.type) {
                 case TranspositionTable::Node::EXACT: 
@@ -76,36 +206,57 @@ namespace Chess::Engine::Negamax {
         }
 
         
-        int moves_c;
-        Move moves[256];
-        MoveGenerator::PreMoveData pre_move_data = MoveGenerator::genPreMoveData(gs);
-        if (pre_move_data.isCheck()) {
-            moves_c = MoveGenerator::genAllMoves(gs, pre_move_data, moves, false); 
-            if (moves_c == 0) return -MATE + ply;
-        } else {
-            // else not in check
-            int static_eval = StaticEvaluation::staticEvaluation(gs, pre_move_data, alpha, beta);
+        int static_eval = -EVAL_INF;
+        MoveGenerator::PreMoveData & pre_move_data = td.stackEntry(ply).pre_move_data;
+        pre_move_data = genSearchPreMoveData(gs);
+        if (!pre_move_data.isCheck()) {
+            static_eval = StaticEvaluation::staticEvaluation(gs, pre_move_data, alpha, beta);
             if (gs.turn == BLACK) static_eval = -static_eval;
             
             if (static_eval >= beta) return static_eval;
             if (static_eval > alpha) alpha = static_eval;
-
-            moves_c = MoveGenerator::genAllMoves(gs, pre_move_data, moves, true); 
-            if (moves_c == 0) {
-                return pre_move_data.isCheck() ? -MATE + ply : alpha; // checkmate / draw
-            }
         }
 
-        orderMoves(gs, moves, moves_c, hit.best_move);
+        // in check every evasion is searched (full staged picker), otherwise only captures that don't lose material on the exchange
+        // first qsearch ply also looks at quiet checks, catches mating nets without searching full width deeper
+        const bool pseudo_legal = generation_mode == GenerationMode::PSEUDO_LEGAL;
+        MovePicker move_picker = pre_move_data.isCheck() ? 
+            MovePicker(gs, pre_move_data, pseudo_legal, hit.best_move, td, ply, td.moveList(ply, false)) : 
+            MovePicker(gs, pre_move_data, pseudo_legal, hit.best_move, td, ply, td.moveList(ply, false), qdepth == 0);
 
         const int ORIG_ALPHA = alpha;
-        int best_score = -EVAL_INF;
+        int best_score = static_eval; // stand pat is the floor when not in check (-EVAL_INF when in check)
         Move best_move;
-        for (int i = 0; i < moves_c; i++) {
-            Move move = moves[i];
+
+        // delta pruning - a capture that can't lift the stand pat score to alpha even with a margin on top of the captured material is skipped
+        const int futility_base = static_eval + StaticEvaluation::delta_margin;
+        bool check_info_ready = false;
+        MoveGenerator::CheckInfo check_info;
+
+        Move move;
+        while ((move = move_picker.next()).v != 0) {
+            if (!pre_move_data.isCheck() && move.isCapture()) {
+                int futility_value = futility_base + StaticEvaluation::getPieceValue(capturedPiece(gs, move));
+                if (move.promo_piece() != PAWN) futility_value += StaticEvaluation::getPieceValue(move.promo_piece()) - StaticEvaluation::getPieceValue(PAWN);
+
+                // even the margin isn't enough, or the exchange doesn't win material while the margin alone isn't enough
+                if (futility_value <= alpha || (futility_base <= alpha && !StaticExchange::see(gs, move, 1))) {
+                    if (!check_info_ready) {
+                        check_info = MoveGenerator::genCheckInfo(gs);
+                        check_info_ready = true;
+                    }
+                    if (!MoveGenerator::givesCheck(gs, check_info, move)) continue; // checks can still win more than the material
+                }
+            }
+
+            td.setStackMove(ply, gs, move);
             Unmove unmove = gs.applyMove(move);
+            if (!isSearchMoveLegal(gs)) {
+                gs.applyUnmove(unmove);
+                continue;
+            }
 
-            int score = -quiescence(gs, tt, -beta, -alpha, ply+1);
+            int score = -quiescence(gs, tt, td, -beta, -alpha, ply+1, qdepth+1);
 
             gs.applyUnmove(unmove);
 
@@ -119,36 +270,61 @@ namespace Chess::Engine::Negamax {
             }
         }
 
+        if (pre_move_data.isCheck() && best_score == -EVAL_INF) return -MATE + ply; // no legal evasion
+
         // store results to TT
         TranspositionTable::Node::Type bound;
         if (best_score <= ORIG_ALPHA) bound = TranspositionTable::Node::UPPERBOUND; // fail-low
         else if (best_score >= beta)  bound = TranspositionTable::Node::LOWERBOUND; // fail-high
         else                          bound = TranspositionTable::Node::EXACT;      // PV node
 
-        int best_score_mate_adjusted = best_score;
-        if (best_score_mate_adjusted >  MATE_THRESHOLD) best_score_mate_adjusted += ply;
-        if (best_score_mate_adjusted < -MATE_THRESHOLD) best_score_mate_adjusted -= ply;
-        tt.add_entry(gs.getHashCode(), best_move, best_score_mate_adjusted, 0, bound);
+        tt.add_entry(gs.getHashCode(), best_move, scoreToTT(best_score, ply), 0, bound);
 
         return best_score;
     }
 
 
 
-    int negamax(GameState & gs, TranspositionTable & tt, int depth, int alpha, int beta, int ply = 0) {
+    int negamax(GameState & gs, TranspositionTable & tt, ThreadData & td, int depth, int alpha, int beta, int ply = 0) {
         /* temp */ ncnt++;
+        td.nodes++;
+
+        if (ply >= MAX_PLY) return evaluateAtMaxPly(gs, td);
+        td.setStackKey(ply, gs.getHashCode());
+        td.clearPV(ply);
+
+        // fifty move rule & repetition - cycling lines end here instead of being searched to full depth (and stored in the tt)
+        if (ply > 0 && gs.halfmove_clock >= 100) { // checkmate on the 100th half move still wins
+            if (gs.isKingAttacked(gs.turn) && MoveGenerator::countAllMoves(gs, MoveGenerator::genPreMoveData(gs)) == 0) return -MATE + ply;
+            return 0;
+        }
+        if (ply > 0 && td.isRepetition(ply, gs)) return 0;
 
         if (depth == 0) {
-            return quiescence(gs, tt, alpha, beta, ply);
+            return quiescence(gs, tt, td, alpha, beta, ply);
         }
 
+        const bool pv_node = beta - alpha > 1; // pv nodes are searched with an open window and can return an exact score, every other node is a zero window scout
+
+        // upcoming repetition - a move from here repeats a position from earlier in the line, this side can always take the draw
+        if (ply > 0 && alpha < 0 && td.hasUpcomingRepetition(ply, gs)) {
+            alpha = 0;
+            if (alpha >= beta) return alpha;
+        }
+
+        // mate distance pruning - nothing below this node can beat getting mated right here or mating on the next move,
+        // so once a shorter mate is known the window closes and the whole subtree is skipped
+        alpha = std::max(alpha, -MATE + ply);
+        beta = std::min(beta, MATE - ply - 1);
+        if (alpha >= beta) return alpha;
+
+        const Move excluded_move = td.getExcludedMove(ply); // set when this is a singular extension search, the tt entry belongs to the full node then
+
         // transposition table hit check
         TranspositionTable::Node hit = tt.findNode(gs.getHashCode());
-        if (hit.is_valid() && hit.depth >= depth) {
+        const int hit_score = scoreFromTT(hit.score, ply);
+        if (hit.is_valid() && hit.depth >= depth && excluded_move.v == 0) {
             tthit++;
-            int hit_score = hit.score;
-            if (hit_score >  MATE_THRESHOLD) hit_score -= ply;   // convert back to node-local POV
-            if (hit_score < -MATE_THRESHOLD) hit_score += ply;
 
             switch (hit.type) {
                 case TranspositionTable::Node::EXACT: 
@@ -168,24 +344,191 @@ namespace Chess::Engine::Negamax {
             }
         }
 
-        Move moves[256];
-        MoveGenerator::PreMoveData pre_move_data = MoveGenerator::genPreMoveData(gs);
-        int moves_c = MoveGenerator::genAllMoves(gs, pre_move_data, moves);
+        MoveGenerator::PreMoveData & pre_move_data = td.stackEntry(ply).pre_move_data;
+        pre_move_data = genSearchPreMoveData(gs);
 
-        if (moves_c == 0) {
-            return pre_move_data.isCheck() ? -MATE + ply : 0; // checkmate / draw
+        const int static_eval = pre_move_data.isCheck() ? ThreadData::NO_EVAL : evaluate(gs, pre_move_data);
+        td.setStaticEval(ply, static_eval);
+        const bool improving = td.isImproving(ply, static_eval);
+
+        const int path_extensions = td.getPathExtensions(ply);
+        td.setPathExtensions(ply, path_extensions); // for the null move search
+
+        // reverse futility pruning - far enough above beta that no quiet reply in the remaining depth is expected to bring it back
+        if (!pv_node && excluded_move.v == 0 && static_eval != ThreadData::NO_EVAL && depth <= RFP_MAX_DEPTH && beta < MATE_THRESHOLD && 
+            static_eval - StaticEvaluation::reverse_futility_margin * (depth - improving) >= beta) {
+            return static_eval;
+        }
+
+        // razoring - so far below alpha that only tactics could help, let qsearch confirm the fail low
+        if (!pv_node && excluded_move.v == 0 && static_eval != ThreadData::NO_EVAL && depth <= RAZOR_MAX_DEPTH && 
+            static_eval + StaticEvaluation::razor_margin * depth < alpha) {
+            const int razor_score = quiescence(gs, tt, td, alpha, beta, ply);
+            if (razor_score <= alpha) return razor_score;
         }
 
-        orderMoves(gs, moves, moves_c, hit.best_move);
+        // null move pruning - if passing the turn still fails high on a reduced search, a real move almost certainly would too
+        // not in check, not right after another null move, and not when zugzwang is likely (only king & pawns left)
+        if (!pv_node && excluded_move.v == 0 && !pre_move_data.isCheck() && depth >= NMP_MIN_DEPTH && ply >= td.nmp_min_ply && 
+            !td.isNullMove(ply - 1) && hasNonPawnMaterial(gs, gs.turn)) {
+            if (static_eval >= beta) {
+                const int R = 3 + depth / 4 + std::min((static_eval - beta) / 200, 3); // adaptive reduction, deeper and further above beta reduces more
+                const int null_depth = std::max(depth - R, 0);
+
+                td.setStackNullMove(ply);
+                const int en_passant_before = gs.applyNullMove();
+                int null_score = -negamax(gs, tt, td, null_depth, -beta, -beta+1, ply+1);
+                gs.undoNullMove(en_passant_before);
+
+                if (null_score >= beta) {
+                    if (null_score >= MATE_THRESHOLD) null_score = beta; // a mate found after passing isn't proven
+                    if (depth < NMP_VERIFICATION_DEPTH || td.nmp_min_ply != 0) return null_score; // no nested verification, it would reset the outer one's guard
+
+                    // verification search - same reduced depth without null moves for this side, catches the zugzwangs the material check misses
+                    td.nmp_min_ply = ply + 3 * null_depth / 4;
+                    const int verification_score = negamax(gs, tt, td, null_depth, beta-1, beta, ply);
+                    td.nmp_min_ply = 0;
+
+                    if (verification_score >= beta) return null_score;
+                }
+            }
+        }
+
+        // internal iterative reduction / deepening, see IIDPolicy
+        Move tt_move = hit.best_move;
+        if (tt_move.v == 0 && excluded_move.v == 0) {
+            if (iid_policy == IIDPolicy::REDUCTION && depth >= (pv_node ? IIR_MIN_DEPTH : IIR_MIN_DEPTH_NON_PV)) {
+                depth--;
+            }
+            else if (iid_policy == IIDPolicy::DEEPENING && depth >= (pv_node ? IID_MIN_DEPTH : IID_MIN_DEPTH_NON_PV)) {
+                negamax(gs, tt, td, pv_node ? depth - 2 : depth / 2, alpha, beta, ply);
+                tt_move = tt.findNode(gs.getHashCode()).best_move;
+                td.clearPV(ply);
+                td.setPathExtensions(ply, path_extensions); // the nested search left its last move's extensions here
+            }
+        }
+
+        // probcut - a capture that beats beta by a margin on a much shallower search will very likely beat beta on the full one
+        // qsearch first so captures that don't even hold up there never cost a reduced search
+        const int probcut_beta = beta + StaticEvaluation::probcut_margin;
+        if (!pv_node && excluded_move.v == 0 && static_eval != ThreadData::NO_EVAL && depth >= PROBCUT_MIN_DEPTH && std::abs(beta) < MATE_THRESHOLD && 
+            !(hit.is_valid() && hit.depth >= depth - 3 && hit_score < probcut_beta)) { // the tt already says this node stays below probcut_beta
+            const bool pseudo_legal = generation_mode == GenerationMode::PSEUDO_LEGAL;
+            MovePicker probcut_picker(gs, pre_move_data, pseudo_legal, tt_move, probcut_beta - static_eval, td, ply, td.moveList(ply, false));
+
+            Move move;
+            while ((move = probcut_picker.next()).v != 0) {
+                td.setStackMove(ply, gs, move);
+                Unmove unmove = gs.applyMove(move);
+                if (!isSearchMoveLegal(gs)) {
+                    gs.applyUnmove(unmove);
+                    continue;
+                }
+
+                int score = -quiescence(gs, tt, td, -probcut_beta, -probcut_beta+1, ply+1);
+                if (score >= probcut_beta) score = -negamax(gs, tt, td, depth - PROBCUT_REDUCTION, -probcut_beta, -probcut_beta+1, ply+1);
+                gs.applyUnmove(unmove);
+
+                if (score >= probcut_beta) {
+                    tt.add_entry(gs.getHashCode(), move, scoreToTT(score, ply), depth - PROBCUT_REDUCTION + 1, TranspositionTable::Node::LOWERBOUND);
+                    return score;
+                }
+            }
+        }
 
         const int ORIG_ALPHA = alpha;
         int best_score = -EVAL_INF;
         Move best_move;
-        for (int i = 0; i < moves_c; i++) {
-            Move move = moves[i];
+        int legal_moves_c = 0;
+        Move quiets_searched[64]; // moves that failed to cut, they get a history malus when a later move does
+        int quiets_searched_c = 0;
+        Move captures_searched[32];
+        int captures_searched_c = 0;
+        int quiets_seen_c = 0; // searched or pruned
+
+        // futility pruning - quiets that don't give check can't raise a static eval this far below alpha within the remaining depth
+        // the first legal move is always searched (best_score is -EVAL_INF until then) so a node never ends up with everything pruned
+        const bool futility_pruning = !pv_node && static_eval != ThreadData::NO_EVAL && depth <= FUTILITY_MAX_DEPTH && 
+                                      static_eval + StaticEvaluation::futility_margin_base + StaticEvaluation::futility_margin * depth <= alpha;
+        const MoveGenerator::CheckInfo check_info = futility_pruning ? MoveGenerator::genCheckInfo(gs) : MoveGenerator::CheckInfo();
+
+        // the picker validates the hash move (a partial hash collision can hand back a move from another position) and searches it before generating anything
+        MovePicker move_picker(gs, pre_move_data, generation_mode == GenerationMode::PSEUDO_LEGAL, tt_move, td, ply, td.moveList(ply, excluded_move.v != 0));
+        Move move;
+        while ((move = move_picker.next()).v != 0) {
+            if (move.v == excluded_move.v) continue;
+
+            const bool is_quiet = !move.isCapture() && move.promo_piece() == PAWN;
+            const int move_history = is_quiet ? td.getQuietHistory(ply, gs.turn, gs.getPieceTypeAtSquare(move.from(), gs.turn), move) : 0;
+
+            // shallow quiet move pruning, never before a legal move has been searched (see futility pruning)
+            if (is_quiet && !pv_node && !pre_move_data.isCheck() && best_score > -MATE_THRESHOLD) {
+                quiets_seen_c++;
+
+                // late move pruning - enough quiets failed low already, the rest are ordered worse so skip them all
+                if (depth <= LMP_MAX_DEPTH && quiets_seen_c >= lateMovePruningCount(depth, improving)) move_picker.skipQuiets();
+
+                if (futility_pruning && !MoveGenerator::givesCheck(gs, check_info, move)) continue;
+
+                // history pruning - quiets that keep failing in this kind of position
+                if (depth <= HISTORY_PRUNING_MAX_DEPTH && move_history < -HISTORY_PRUNING_MARGIN * depth) continue;
+            }
+
+            // singular extension - the tt move is the only good move if every other move fails low against a bound below its score
+            // searched with the tt move excluded at reduced depth, a forced move like that deserves another ply
+            int extension = 0;
+            if (depth >= SINGULAR_MIN_DEPTH && move.v == hit.best_move.v && excluded_move.v == 0 && path_extensions < EXTENSION_BUDGET &&
+                hit.depth >= depth - 3 && hit.type != TranspositionTable::Node::UPPERBOUND && std::abs(hit_score) < MATE_THRESHOLD) {
+                const int singular_beta = hit_score - SINGULAR_MARGIN * depth;
+
+                td.setExcludedMove(ply, move);
+                const int singular_score = negamax(gs, tt, td, (depth - 1) / 2, singular_beta - 1, singular_beta, ply);
+                td.setExcludedMove(ply, Move());
+
+                if (singular_score < singular_beta) extension = 1;
+                else if (singular_beta >= beta) return singular_beta; // multi cut - another move beats beta as well, this node fails high either way
+            }
+
+            td.setStackMove(ply, gs, move);
             Unmove unmove = gs.applyMove(move);
+            if (!isSearchMoveLegal(gs)) {
+                gs.applyUnmove(unmove);
+                continue;
+            }
+            legal_moves_c++;
+
+            // check extension, recapture extension (pv only, keeps exchanges that started before the horizon from being cut in half)
+            const bool gives_check = gs.isKingAttacked(gs.turn);
+            if (gives_check || (pv_node && td.isRecapture(ply, move))) extension = 1;
+            if (path_extensions >= EXTENSION_BUDGET) extension = 0;
+            td.setPathExtensions(ply, path_extensions + extension);
+
+            const int new_depth = depth - 1 + extension;
+            int score = -EVAL_INF;
+            bool full_depth_scout = !pv_node || legal_moves_c > 1;
+
+            // late move reductions - quiets ordered late rarely beat alpha, scout them at a reduced depth first and only
+            // search them at full depth if they do
+            if (depth >= LMR_MIN_DEPTH && legal_moves_c > 1 + pv_node && is_quiet && !pre_move_data.isCheck()) {
+                int r = reductions.get(depth, legal_moves_c);
+                if (pv_node) r--;
+                if (!improving) r++;
+                if (gives_check) r--;
+                r -= move_history / LMR_HISTORY_DIVISOR;
+
+                const int reduced_depth = std::clamp(new_depth - r, 1, new_depth);
+                score = -negamax(gs, tt, td, reduced_depth, -alpha-1, -alpha, ply+1);
+                full_depth_scout = score > alpha && reduced_depth < new_depth;
+            }
 
-            int score = -negamax(gs, tt, depth-1, -beta, -alpha, ply+1);
+            // principal variation search: the first move gets the full window, the rest are only scouted with a zero window
+            // and re-searched with the full window if the scout shows they beat alpha (non pv nodes only ever have a zero window)
+            if (full_depth_scout) {
+                score = -negamax(gs, tt, td, new_depth, -alpha-1, -alpha, ply+1);
+            }
+            if (pv_node && (legal_moves_c == 1 || (score > alpha && score < beta))) {
+                score = -negamax(gs, tt, td, new_depth, -beta, -alpha, ply+1);
+            }
 
             gs.applyUnmove(unmove);
 
@@ -195,8 +538,22 @@ namespace Chess::Engine::Negamax {
             }
             if (score > alpha) {
                 alpha = score;
-                if (alpha >= beta) break;
+                if (pv_node) td.updatePV(ply, move);
+                if (alpha >= beta) {
+                    /* temp */ betacut++;
+                    /* temp */ if (legal_moves_c == 1) firstcut++;
+
+                    updateCutoffStats(gs, td, move, quiets_searched, quiets_searched_c, captures_searched, captures_searched_c, depth, ply);
+                    break;
+                }
             }
+            if (!move.isCapture() && quiets_searched_c < 64) quiets_searched[quiets_searched_c++] = move;
+            else if (move.isCapture() && captures_searched_c < 32) captures_searched[captures_searched_c++] = move;
+        }
+
+        if (legal_moves_c == 0) {
+            if (excluded_move.v != 0) return alpha; // the excluded move is the only legal one, not a mate or stalemate
+            return pre_move_data.isCheck() ? -MATE + ply : 0; // checkmate / draw
         }
 
         // store results to TT
@@ -205,10 +562,7 @@ namespace Chess::Engine::Negamax {
         else if (best_score >= beta)  bound = TranspositionTable::Node::LOWERBOUND; // fail-high
         else                          bound = TranspositionTable::Node::EXACT;      // PV node
 
-        int best_score_mate_adjusted = best_score;
-        if (best_score_mate_adjusted >  MATE_THRESHOLD) best_score_mate_adjusted += ply;
-        if (best_score_mate_adjusted < -MATE_THRESHOLD) best_score_mate_adjusted -= ply;
-        tt.add_entry(gs.getHashCode(), best_move, best_score_mate_adjusted, depth, bound);
+        if (excluded_move.v == 0) tt.add_entry(gs.getHashCode(), best_move, scoreToTT(best_score, ply), depth, bound); // an exclusion search result would overwrite the full node's entry
 
         return best_score;
     }
@@ -13,10 +13,11 @@ namespace Chess::Engine::Perft {
     U64 perft(GameState& gs, int depth, bool top_depth = true) {
         if (depth == 0) return 1;
 
-        Move moves[256];
         MoveGenerator::PreMoveData pre_move_data = MoveGenerator::genPreMoveData(gs);
+        if (depth == 1) return MoveGenerator::countAllMoves(gs, pre_move_data); // bulk count leaves, no need to build the move list
+
+        Move moves[256];
         int n = MoveGenerator::genAllMoves(gs, pre_move_data, moves);
-        if (depth == 1) return n;
 
         U64 nodes = 0;
         for (int i = 0; i < n; ++i) {
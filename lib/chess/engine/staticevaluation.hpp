@@ -12,6 +12,14 @@ namespace Chess::Engine::StaticEvaluation {
     static constexpr int castle_single_weight = 20;
     static constexpr int castle_double_weight = 30;
 
+    // search pruning margins, how far the static eval is trusted to be off (scaled by remaining depth)
+    static constexpr int reverse_futility_margin = 75;   // per ply
+    static constexpr int futility_margin_base = 100;
+    static constexpr int futility_margin = 100;          // per ply
+    static constexpr int razor_margin = 200;             // per ply
+    static constexpr int delta_margin = 200;             // quiescence, on top of the captured piece value
+    static constexpr int probcut_margin = 150;           // probcut searches against beta + this
+
 
     int getPieceValue(PIECE piece) {
         switch (piece) {
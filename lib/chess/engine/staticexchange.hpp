@@ -0,0 +1,79 @@
+#pragma once
+
+#include <lib/chess/util.hpp>
+#include <lib/chess/gamestate.hpp>
+#include <lib/chess/move.hpp>
+#include <lib/chess/attacks.hpp>
+#include <lib/lookuptables/bitboards.hpp>
+
+#include <lib/chess/engine/staticevaluation.hpp>
+
+namespace Chess::Engine::StaticExchange {
+
+    inline U64 attackersTo(const GameState & gs, int square, U64 occupied_spaces) { // both colors, sliders use the given occupancy so x-rays can be revealed
+        return (Bitboards::pawn_attacks[square][BLACK] & gs.pieces[WHITE][PAWN]) |
+               (Bitboards::pawn_attacks[square][WHITE] & gs.pieces[BLACK][PAWN]) |
+               (Bitboards::knight_moves[square] & (gs.pieces[WHITE][KNIGHT] | gs.pieces[BLACK][KNIGHT])) |
+               (Bitboards::king_moves[square] & (gs.pieces[WHITE][KING] | gs.pieces[BLACK][KING])) |
+               (Attacks::genBishopRays(square, occupied_spaces) & (gs.pieces[WHITE][BISHOP] | gs.pieces[BLACK][BISHOP] | gs.pieces[WHITE][QUEEN] | gs.pieces[BLACK][QUEEN])) |
+               (Attacks::genRookRays(square, occupied_spaces) & (gs.pieces[WHITE][ROOK] | gs.pieces[BLACK][ROOK] | gs.pieces[WHITE][QUEEN] | gs.pieces[BLACK][QUEEN]));
+    }
+
+    // static exchange evaluation - true if the exchange sequence started by move on its target square nets at least threshold (side to move pov)
+    // both sides always recapture with their least valuable attacker and may stop whenever continuing would lose material, pins are ignored
+    bool see(const GameState & gs, const Move & move, int threshold) {
+        if (gs.isMoveCastle(move)) return 0 >= threshold;
+
+        const int from = move.from();
+        const int to = move.to();
+        const bool is_en_passant = gs.isMoveEnPassant(move);
+        const PIECE moving_piece = gs.getPieceTypeAtSquare(from, gs.turn);
+        const PIECE standing_piece = (moving_piece == PAWN && move.promo_piece() != PAWN) ? move.promo_piece() : moving_piece; // what the opponent can win back on the square
+
+        int swap = -threshold;
+        if (move.isCapture()) swap += StaticEvaluation::getPieceValue(is_en_passant ? PAWN : gs.getPieceTypeAtSquare(to, (COLOR) !gs.turn));
+        if (standing_piece != moving_piece) swap += StaticEvaluation::getPieceValue(standing_piece) - StaticEvaluation::getPieceValue(PAWN);
+        if (swap < 0) return false; // even if the opponent can't recapture the threshold isn't met
+
+        swap = StaticEvaluation::getPieceValue(standing_piece) - swap;
+        if (swap <= 0) return true; // even losing the piece keeps the threshold
+
+        U64 occupied = gs.occupied_spaces ^ squareToBitboard(from) ^ squareToBitboard(to);
+        if (is_en_passant) occupied ^= squareToBitboard(to + (gs.turn == WHITE ? -8 : 8));
+
+        const U64 diagonal_sliders = gs.pieces[WHITE][BISHOP] | gs.pieces[BLACK][BISHOP] | gs.pieces[WHITE][QUEEN] | gs.pieces[BLACK][QUEEN];
+        const U64 orthogonal_sliders = gs.pieces[WHITE][ROOK] | gs.pieces[BLACK][ROOK] | gs.pieces[WHITE][QUEEN] | gs.pieces[BLACK][QUEEN];
+
+        U64 attackers = attackersTo(gs, to, occupied);
+        COLOR stm = gs.turn;
+        int result = 1;
+
+        while (true) {
+            stm = (COLOR) !stm;
+            attackers &= occupied;
+
+            const U64 stm_attackers = attackers & gs.occupied_spaces_color[stm];
+            if (!stm_attackers) break;
+
+            result ^= 1;
+
+            // least valuable attacker captures, then reveal any slider behind it
+            int piece_type = PAWN;
+            while (!(stm_attackers & gs.pieces[stm][piece_type])) piece_type++;
+
+            if (piece_type == KING) { // the king can only take if the opponent has nothing left to recapture with
+                return (attackers & gs.occupied_spaces_color[!stm]) ? result ^ 1 : result;
+            }
+
+            swap = StaticEvaluation::getPieceValue((PIECE) piece_type) - swap;
+            if (swap < result) break;
+
+            occupied ^= squareToBitboard(getLeastBitboardSquare(stm_attackers & gs.pieces[stm][piece_type]));
+            if (piece_type == PAWN || piece_type == BISHOP || piece_type == QUEEN) attackers |= Attacks::genBishopRays(to, occupied) & diagonal_sliders;
+            if (piece_type == ROOK || piece_type == QUEEN)                         attackers |= Attacks::genRookRays(to, occupied) & orthogonal_sliders;
+        }
+
+        return result;
+    }
+
+}
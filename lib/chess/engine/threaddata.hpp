@@ -0,0 +1,268 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+
+#include <lib/chess/util.hpp>
+#include <lib/chess/attacks.hpp>
+#include <lib/chess/gamestate.hpp>
+#include <lib/chess/move.hpp>
+#include <lib/chess/movegenerator.hpp>
+
+#include <lib/chess/engine/cuckoo.hpp>
+
+namespace Chess::Engine {
+
+    constexpr int MAX_PLY = 128; // deepest ply that has per ply search state
+
+// search state owned by a single search thread - move ordering statistics learned while searching
+// nothing in here is shared between threads, so none of it needs to be atomic
+struct ThreadData {
+    struct MoveList { // backing storage of a MovePicker
+        Move moves[256];
+        int scores[256];
+    };
+
+    // per ply node data, everything a node needs beyond a few locals lives here instead of on the recursion stack
+    // preallocated once per thread, so a deep line reuses the same memory every iteration and later plies can read back earlier ones
+    struct StackEntry {
+        Move move;   // move made at this ply, empty if no move was made (null move, root or above)
+        COLOR color; // side that made it
+        PIECE piece; // piece that moved
+        int static_eval; // side to move pov, NO_EVAL when in check
+        Move excluded_move; // skipped by the singular extension search run at this ply
+        int extensions; // plies of extension on the path up to and including the move made at this ply
+        U64 key; // hash code of the position at this ply
+
+        Move killers[2]; // quiet moves that caused a beta cutoff at this ply, slot 0 is the most recent
+        Move pv[MAX_PLY]; // principal variation from this ply, only built in pv nodes
+        int pv_length;
+
+        MoveGenerator::PreMoveData pre_move_data; // of the position at this ply, a search re-entering the same ply regenerates the same data
+        MoveList move_lists[2]; // [0] the node's own picker, [1] the singular extension search nested at this ply (the only search that runs while the node's picker is live)
+    };
+    static constexpr int NO_EVAL = -32768;
+    using ContinuationHistory = I16[2][6][64][6][64]; // [previous move color][previous move piece][previous move to][piece][to]
+
+    Move counter_moves[2][6][64];  // [color][piece][to] of the previous move -> the quiet move that last refuted it
+    I16 history[2][64][64];        // [color][from][to] butterfly history, quiet moves only
+    I16 capture_history[2][6][64][6]; // [color][piece][to][victim], refines the static mvv_lva order
+    ContinuationHistory continuation_history[2]; // [0] keyed by the move 1 ply back (the reply), [1] by the move 2 plies back (own follow up)
+
+    StackEntry stack[MAX_PLY + 3]; // offset by 2 so every ply can look 2 plies back, go through stackEntry(), nodes are only searched below MAX_PLY (a leaf at MAX_PLY just gets evaluated)
+
+    int nmp_min_ply = 0; // null move pruning is disabled before this ply while a null move verification search runs
+
+    long long nodes = 0; // negamax + quiescence nodes searched by this thread since the search started
+
+    std::vector<U64> game_keys; // hash codes of the positions played before the root, oldest first, set by the engine each search
+
+    static constexpr int HISTORY_MAX = 16384; // history scores stay within +-HISTORY_MAX
+
+    ThreadData() {
+        clear();
+    }
+
+    void clear() {
+        std::memset(counter_moves, 0, sizeof(counter_moves));
+        std::memset(history, 0, sizeof(history));
+        std::memset(capture_history, 0, sizeof(capture_history));
+        std::memset(continuation_history, 0, sizeof(continuation_history));
+        clearStack();
+        nmp_min_ply = 0;
+        nodes = 0;
+    }
+    void newSearch() { // killers are position specific, history is still mostly relevant after a move is played so it's only aged
+        clearStack();
+        nmp_min_ply = 0;
+        nodes = 0;
+        ageTable(&history[0][0][0], sizeof(history) / sizeof(I16));
+        ageTable(&capture_history[0][0][0][0], sizeof(capture_history) / sizeof(I16));
+        ageTable(&continuation_history[0][0][0][0][0][0], sizeof(continuation_history) / sizeof(I16));
+    }
+
+    inline StackEntry & stackEntry(int ply) {
+        return stack[ply + 2];
+    }
+    inline const StackEntry & stackEntry(int ply) const {
+        return stack[ply + 2];
+    }
+    inline void setStackMove(int ply, const GameState & gs, const Move & move) { // call before the move is applied
+        if (ply >= MAX_PLY) return;
+        StackEntry & entry = stackEntry(ply);
+        entry.move = move;
+        entry.color = gs.turn;
+        entry.piece = gs.getPieceTypeAtSquare(move.from(), gs.turn);
+    }
+
+    inline void setStackNullMove(int ply) { // an empty move, nothing is keyed by a null move
+        if (ply >= MAX_PLY) return;
+        stackEntry(ply).move = Move();
+    }
+    inline bool isNullMove(int ply) const { // true if the move made at ply was a null move
+        return ply >= 0 && ply < MAX_PLY && stackEntry(ply).move.v == 0;
+    }
+
+    inline void setStaticEval(int ply, int static_eval) {
+        if (ply >= MAX_PLY) return;
+        stackEntry(ply).static_eval = static_eval;
+    }
+    inline MoveList & moveList(int ply, bool nested) {
+        return stackEntry(ply).move_lists[nested];
+    }
+
+    inline void clearPV(int ply) {
+        stackEntry(ply).pv_length = 0;
+    }
+    inline void updatePV(int ply, const Move & move) { // move is the new best at ply, its pv continues with the child's
+        StackEntry & entry = stackEntry(ply);
+        entry.pv[0] = move;
+        entry.pv_length = 1;
+        if (ply + 1 >= MAX_PLY) return;
+        const StackEntry & child = stackEntry(ply + 1);
+        std::copy(child.pv, child.pv + child.pv_length, entry.pv + 1);
+        entry.pv_length += child.pv_length;
+    }
+
+    inline bool isImproving(int ply, int static_eval) const { // static eval went up since this side's previous move, pruning can be more careful when it didn't
+        if (ply >= MAX_PLY || static_eval == NO_EVAL) return false;
+        const int previous_eval = stackEntry(ply - 2).static_eval;
+        return previous_eval == NO_EVAL || static_eval > previous_eval; // previous move was made in check, treat as improving to stay safe
+    }
+
+    inline void setStackKey(int ply, U64 key) {
+        if (ply < MAX_PLY) stackEntry(ply).key = key;
+    }
+    // the position at ply already occurred since the last irreversible move - once inside the search tree, twice if at or before the root (threefold)
+    // walks back through the search stack then game_keys, a null move on the way ends it (the positions across it were never really played)
+    bool isRepetition(int ply, const GameState & gs) const {
+        if (ply >= MAX_PLY) return false;
+        const U64 key = gs.getHashCode();
+        int before_root_c = 0;
+        U64 earlier_key;
+        for (int distance = 1; distance <= (int) gs.halfmove_clock && getEarlierKey(ply, distance, earlier_key); distance++) {
+            if (distance % 2 == 0 && earlier_key == key && (distance < ply || ++before_root_c == 2)) return true; // same side to move only every other ply
+        }
+        return false;
+    }
+    // a single reversible move from the position at ply reaches a position from earlier in the search tree (the side to move can draw by repetition)
+    // found by looking the hash code difference up in the cuckoo table, then checking nothing stands in the way of the move
+    bool hasUpcomingRepetition(int ply, const GameState & gs) const {
+        if (ply >= MAX_PLY) return false;
+        const U64 key = gs.getHashCode();
+        U64 earlier_key;
+        for (int distance = 1; distance < ply && distance <= (int) gs.halfmove_clock && getEarlierKey(ply, distance, earlier_key); distance++) {
+            if (distance < 3 || distance % 2 == 0) continue; // the other side to move, 1 ply back is just the previous move undone
+            const Move move = cuckoo.find(key ^ earlier_key);
+            if (move.v != 0 && !(Attacks::genBetweenSquares(move.from(), move.to()) & gs.occupied_spaces)) return true;
+        }
+        return false;
+    }
+
+    inline Move getExcludedMove(int ply) const {
+        return ply < MAX_PLY ? stackEntry(ply).excluded_move : Move();
+    }
+    inline void setExcludedMove(int ply, const Move & move) {
+        if (ply < MAX_PLY) stackEntry(ply).excluded_move = move;
+    }
+    inline int getPathExtensions(int ply) const { // extensions on the path to the node at ply, past the stack it reports MAX_PLY so no budget allows more
+        return ply <= MAX_PLY ? stackEntry(ply - 1).extensions : MAX_PLY;
+    }
+    inline void setPathExtensions(int ply, int extensions) { // for the children of the node at ply
+        if (ply < MAX_PLY) stackEntry(ply).extensions = extensions;
+    }
+    inline bool isRecapture(int ply, const Move & move) const { // move captures back on the square the previous move captured on
+        if (ply >= MAX_PLY) return false;
+        const Move & previous = stackEntry(ply - 1).move;
+        return move.isCapture() && previous.v != 0 && previous.isCapture() && previous.to() == move.to();
+    }
+
+    inline void storeKiller(int ply, const Move & move) {
+        if (ply >= MAX_PLY) return;
+        Move * killers = stackEntry(ply).killers;
+        if (killers[0].v == move.v) return;
+        killers[1] = killers[0];
+        killers[0] = move;
+    }
+    inline Move getCounterMove(int ply) const {
+        if (ply >= MAX_PLY) return Move();
+        const StackEntry & previous = stackEntry(ply - 1);
+        return previous.move.v != 0 ? counter_moves[previous.color][previous.piece][previous.move.to()] : Move();
+    }
+    inline void storeCounterMove(int ply, const Move & move) {
+        if (ply >= MAX_PLY) return;
+        const StackEntry & previous = stackEntry(ply - 1);
+        if (previous.move.v != 0) counter_moves[previous.color][previous.piece][previous.move.to()] = move;
+    }
+
+    static inline int historyBonus(int depth) { // cutoffs deep in the tree are worth more than ones near the leaves
+        return std::min(32 * depth * depth, 1536);
+    }
+    static inline void updateHistoryEntry(I16 & entry, int bonus) { // gravity: the closer an entry is to HISTORY_MAX the less it moves, so old results fade out
+        entry += bonus - entry * std::abs(bonus) / HISTORY_MAX;
+    }
+
+    // quiet moves - butterfly + continuation history of the moves 1 and 2 plies back
+    inline int getQuietHistory(int ply, COLOR color, PIECE piece, const Move & move) const {
+        int score = history[color][move.from()][move.to()];
+        if (ply < MAX_PLY) {
+            for (int i = 0; i < 2; i++) {
+                const StackEntry & previous = stackEntry(ply - 1 - i);
+                if (previous.move.v != 0) score += continuation_history[i][previous.color][previous.piece][previous.move.to()][piece][move.to()];
+            }
+        }
+        return score;
+    }
+    inline void updateQuietHistory(int ply, COLOR color, PIECE piece, const Move & move, int bonus) {
+        updateHistoryEntry(history[color][move.from()][move.to()], bonus);
+        if (ply < MAX_PLY) {
+            for (int i = 0; i < 2; i++) {
+                const StackEntry & previous = stackEntry(ply - 1 - i);
+                if (previous.move.v != 0) updateHistoryEntry(continuation_history[i][previous.color][previous.piece][previous.move.to()][piece][move.to()], bonus);
+            }
+        }
+    }
+
+    inline int getCaptureHistory(COLOR color, PIECE piece, int to, PIECE victim) const {
+        return capture_history[color][piece][to][victim];
+    }
+    inline void updateCaptureHistory(COLOR color, PIECE piece, int to, PIECE victim, int bonus) {
+        updateHistoryEntry(capture_history[color][piece][to][victim], bonus);
+    }
+
+private:
+    // hash code of the position distance plies before the one at ply, from the stack and then game_keys
+    // false once the history runs out or a null move is crossed, so distance has to be walked up one at a time
+    inline bool getEarlierKey(int ply, int distance, U64 & key) const {
+        const int earlier_ply = ply - distance;
+        if (earlier_ply >= 0) {
+            if (stackEntry(earlier_ply).move.v == 0) return false; // the positions across a null move were never really played
+            key = stackEntry(earlier_ply).key;
+            return true;
+        }
+        const int game_i = (int) game_keys.size() + earlier_ply;
+        if (game_i < 0) return false;
+        key = game_keys[game_i];
+        return true;
+    }
+
+    inline void clearStack() {
+        for (StackEntry & entry : stack) { // move lists & pre move data are always written before they're read
+            entry.move = Move();
+            entry.color = WHITE;
+            entry.piece = PAWN;
+            entry.static_eval = NO_EVAL;
+            entry.excluded_move = Move();
+            entry.extensions = 0;
+            entry.key = 0;
+            entry.killers[0] = entry.killers[1] = Move();
+            entry.pv_length = 0;
+        }
+    }
+    static inline void ageTable(I16 * table, size_t entries_c) {
+        for (size_t i = 0; i < entries_c; i++) table[i] /= 2;
+    }
+};
+}
@@ -1,7 +1,6 @@
 #pragma once
 
 #include <vector>
-#include <stack>
 #include <cctype>
 
 #include <lib/chess/gamestate.hpp>
@@ -29,7 +28,7 @@ protected:
     std::vector<std::string> available_formatted_moves;
 
     // move history
-    std::stack<Unmove> undo_stack = std::stack<Unmove>();
+    std::vector<Unmove> undo_stack = std::vector<Unmove>(); // used as a stack, a vector so the history can be walked (see getKeyHistory)
 
 public:
     Game(GameState load_game_state = FEN::FENToGameState("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1")):
@@ -47,7 +46,7 @@ public:
         if (move_index < 0 || move_index >= moves_c) return false;
 
         // apply move and undo stack
-        undo_stack.push(game_state.applyMove(moves[move_index]));
+        undo_stack.push_back(game_state.applyMove(moves[move_index]));
         updateAvaliableMoves();
         return true;
     }
@@ -62,10 +61,17 @@ public:
         return available_formatted_moves;
     }
 
+    std::vector<U64> getKeyHistory() const { // hash codes of every position before the current one, oldest first (for the engine's repetition detection)
+        std::vector<U64> keys;
+        keys.reserve(undo_stack.size());
+        for (const Unmove & unmove : undo_stack) keys.push_back(unmove.hash_before);
+        return keys;
+    }
+
     bool undo_move() {
         if (undo_stack.size() == 0) return false;
-        game_state.applyUnmove(undo_stack.top());
-        undo_stack.pop();
+        game_state.applyUnmove(undo_stack.back());
+        undo_stack.pop_back();
         updateAvaliableMoves();
         return true;
     }
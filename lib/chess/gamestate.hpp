@@ -11,6 +11,7 @@
 #include <lib/chess/util.hpp>
 #include <lib/chess/move.hpp>
 #include <lib/chess/unmove.hpp>
+#include <lib/chess/attacks.hpp>
 
 #include <lib/lookuptables/zobristhashes.hpp>
 
@@ -120,6 +121,17 @@ public:
         en_passant = square;
     }
 
+// attacks
+public:
+    inline bool isKingAttacked(COLOR color) const {
+        const int king_square = getLeastBitboardSquare(pieces[color][KING]);
+        return (Bitboards::pawn_attacks[king_square][color] & pieces[!color][PAWN]) ||
+               (Bitboards::knight_moves[king_square] & pieces[!color][KNIGHT]) ||
+               (Attacks::genBishopRays(king_square, occupied_spaces) & (pieces[!color][BISHOP] | pieces[!color][QUEEN])) ||
+               (Attacks::genRookRays(king_square, occupied_spaces) & (pieces[!color][ROOK] | pieces[!color][QUEEN])) ||
+               (Bitboards::king_moves[king_square] & pieces[!color][KING]);
+    }
+
 // comparison
 public:
     // equality
@@ -294,9 +306,11 @@ public:
         alternateTurn();
 
         // debug check!!
+#ifndef NDEBUG
         U64 old_hash_temp = getHashCode();
         recalculateHashCode();
         assert(old_hash_temp == getHashCode());
+#endif
 
         return um;
     }
@@ -346,9 +360,36 @@ public:
 
         
         // debug check!!
+#ifndef NDEBUG
+        U64 old_hash_temp = getHashCode();
+        recalculateHashCode();
+        assert(old_hash_temp == getHashCode());
+#endif
+    }
+
+
+    // null move - the side to move passes, only for search pruning (never legal in a real game, the side to move must not be in check)
+    // the board is untouched, returns the en passant square to hand back to undoNullMove
+    inline int applyNullMove() {
+        /* FOR DEBUG */ assert(!isKingAttacked(turn));
+
+        const int en_passant_before = en_passant;
+        setEnPassantSquare(-1);
+        alternateTurn();
+
+        return en_passant_before;
+    }
+
+    inline void undoNullMove(const int en_passant_before) {
+        alternateTurn();
+        setEnPassantSquare(en_passant_before);
+
+        // debug check!!
+#ifndef NDEBUG
         U64 old_hash_temp = getHashCode();
         recalculateHashCode();
         assert(old_hash_temp == getHashCode());
+#endif
     }
 
 };
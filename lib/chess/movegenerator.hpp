@@ -5,8 +5,8 @@
 #include <lib/chess/gamestate.hpp>
 #include <lib/chess/ascii.hpp>
 #include <lib/chess/move.hpp>
+#include <lib/chess/attacks.hpp>
 #include <lib/lookuptables/bitboards.hpp>
-#include <lib/lookuptables/magicbitboards.hpp>
 
 #include <lib/chess/fen.hpp>
 
@@ -59,9 +59,21 @@ public:
         }
     };
 
+    enum GEN_TYPE { // which part of the move list to generate, ALL_MOVES == CAPTURES + QUIETS (quiet promotions count as quiets)
+        ALL_MOVES,
+        CAPTURES,
+        QUIETS
+    };
+
+    struct CheckInfo { // data for finding moves that give check to the enemy king (from the side to move's pov)
+        int king_square; // enemy king
+        U64 check_squares[6]; // [piece type] squares a friendly piece of that type would give check from
+        U64 discovered_check_blockers; // friendly pieces that are the only blocker between a friendly slider and the enemy king
+    };
+
 public:
 
-    static inline unsigned int genAllMoves(const GameState & gs, const PreMoveData & pre_move_data, Move * moves_v, bool gen_only_captures = false) { // returns move_c
+    static inline unsigned int genAllMoves(const GameState & gs, const PreMoveData & pre_move_data, Move * moves_v, GEN_TYPE gen_type = ALL_MOVES) { // returns move_c
         unsigned int moves_c = 0;
 
         const U64 enemy_controlled_squares = pre_move_data.controlled_squares_unfriendly;
@@ -72,39 +84,263 @@ public:
 
         if (enemy_checks.is_double_check) {
             // just king moves
-            genKing(gs, moves_c, moves_v, enemy_controlled_squares, gen_only_captures);
+            genKing(gs, moves_c, moves_v, enemy_controlled_squares, gen_type);
         }
         else {
             // all moves
-            genPawns(gs, moves_c, moves_v, check_evasion_bitboard, enemy_pins, gen_only_captures);
-            genKnights(gs, moves_c, moves_v, check_evasion_bitboard, enemy_pins, gen_only_captures);
-            genBishops(gs, moves_c, moves_v, check_evasion_bitboard, enemy_pins, gen_only_captures);
-            genRooks(gs, moves_c, moves_v, check_evasion_bitboard, enemy_pins, gen_only_captures);
-            genQueens(gs, moves_c, moves_v, check_evasion_bitboard, enemy_pins, gen_only_captures);
-            genKing(gs, moves_c, moves_v, enemy_controlled_squares, gen_only_captures);
+            genPawns(gs, moves_c, moves_v, check_evasion_bitboard, enemy_pins, gen_type);
+            genKnights(gs, moves_c, moves_v, check_evasion_bitboard, enemy_pins, gen_type);
+            genBishops(gs, moves_c, moves_v, check_evasion_bitboard, enemy_pins, gen_type);
+            genRooks(gs, moves_c, moves_v, check_evasion_bitboard, enemy_pins, gen_type);
+            genQueens(gs, moves_c, moves_v, check_evasion_bitboard, enemy_pins, gen_type);
+            genKing(gs, moves_c, moves_v, enemy_controlled_squares, gen_type);
         }   
 
         return moves_c;
     }
-    static inline PreMoveData genPreMoveData(const GameState & gs) {
+    static inline unsigned int genPseudoLegalMoves(const GameState & gs, const PreMoveData & pre_move_data, Move * moves_v, GEN_TYPE gen_type = ALL_MOVES) { // returns move_c - like genAllMoves but pins are ignored, check each move with isLegalAfterMove once it is actually searched
+        unsigned int moves_c = 0;
+
+        const U64 enemy_controlled_squares = pre_move_data.controlled_squares_unfriendly;
+        const CheckData & enemy_checks = pre_move_data.check_data;
+        static const PinData no_pins = PinData();
+
+        const U64 check_evasion_bitboard = enemy_checks.checkers_bitboard ? enemy_checks.evasion_bitboard : ~0ULL; // evasions are still filtered, in check almost every other move would be rejected later
+
+        if (enemy_checks.is_double_check) {
+            genKing(gs, moves_c, moves_v, enemy_controlled_squares, gen_type);
+        }
+        else {
+            genPawns(gs, moves_c, moves_v, check_evasion_bitboard, no_pins, gen_type);
+            genKnights(gs, moves_c, moves_v, check_evasion_bitboard, no_pins, gen_type);
+            genBishops(gs, moves_c, moves_v, check_evasion_bitboard, no_pins, gen_type);
+            genRooks(gs, moves_c, moves_v, check_evasion_bitboard, no_pins, gen_type);
+            genQueens(gs, moves_c, moves_v, check_evasion_bitboard, no_pins, gen_type);
+            genKing(gs, moves_c, moves_v, enemy_controlled_squares, gen_type);
+        }
+
+        return moves_c;
+    }
+    static inline bool isLegalAfterMove(const GameState & gs) { // deferred legality check for pseudo legal moves - call after applyMove, true if the side that moved did not leave its king attacked
+        return !gs.isKingAttacked((COLOR) !gs.turn);
+    }
+    static inline unsigned int countAllMoves(const GameState & gs, const PreMoveData & pre_move_data) { // returns the same move_c as genAllMoves without materialising any moves - for perft bulk counting & mobility
+        const U64 enemy_controlled_squares = pre_move_data.controlled_squares_unfriendly;
+        const CheckData & enemy_checks = pre_move_data.check_data;
+        const PinData & enemy_pins = pre_move_data.pin_data;
+
+        const U64 check_evasion_bitboard = enemy_checks.checkers_bitboard ? enemy_checks.evasion_bitboard : ~0ULL;
+
+        if (enemy_checks.is_double_check) {
+            return countKing(gs, enemy_controlled_squares);
+        }
+        return countPawns(gs, check_evasion_bitboard, enemy_pins) +
+               countPieces(gs, check_evasion_bitboard, enemy_pins) +
+               countKing(gs, enemy_controlled_squares);
+    }
+    static inline unsigned int genQuietChecks(const GameState & gs, const PreMoveData & pre_move_data, const CheckInfo & check_info, Move * moves_v) { // returns move_c - non capture, non promotion moves that give check (castling checks are not included)
+        unsigned int moves_c = 0;
+
+        const CheckData & enemy_checks = pre_move_data.check_data;
+        const PinData & enemy_pins = pre_move_data.pin_data;
+
+        const U64 check_evasion_bitboard = enemy_checks.checkers_bitboard ? enemy_checks.evasion_bitboard : ~0ULL;
+        const U64 empty_spaces = ~gs.occupied_spaces;
+
+        if (!enemy_checks.is_double_check) {
+            for (int piece_type = PAWN; piece_type <= QUEEN; piece_type++) {
+                U64 bb = gs.pieces[gs.turn][piece_type];
+                while (bb) {
+                    const int from = getLeastBitboardSquare(bb);
+
+                    U64 targets = 0;
+                    switch (piece_type) {
+                        case PAWN:
+                            targets = Bitboards::pawn_pushes[from][gs.turn] & empty_spaces;
+                            if (targets) targets |= Bitboards::pawn_double_pushes[from][gs.turn] & empty_spaces;
+                            targets &= ~Bitboards::rows[gs.turn == WHITE ? 7 : 0]; // promotions are not quiet
+                            break;
+                        case KNIGHT: targets = Bitboards::knight_moves[from]; break;
+                        case BISHOP: targets = genBishopRays(from, gs.occupied_spaces); break;
+                        case ROOK:   targets = genRookRays(from, gs.occupied_spaces); break;
+                        case QUEEN:  targets = genBishopRays(from, gs.occupied_spaces) | genRookRays(from, gs.occupied_spaces); break;
+                    }
+                    targets &= empty_spaces & check_evasion_bitboard;
+                    if (squareToBitboard(from) & enemy_pins.pins) targets &= enemy_pins.allowed_moves[from];
+
+                    U64 checking_targets = targets & check_info.check_squares[piece_type];
+                    if (squareToBitboard(from) & check_info.discovered_check_blockers) checking_targets |= targets & ~genRayThrough(check_info.king_square, from); // any move off the line reveals the slider
+
+                    while (checking_targets) {
+                        addMove(moves_c, moves_v, Move(from, getLeastBitboardSquare(checking_targets), Move::PROMO::NONE, false));
+                        checking_targets &= checking_targets - 1;
+                    }
+                    bb &= bb - 1;
+                }
+            }
+        }
+
+        // the king can only give a discovered check
+        const int king_square = getLeastBitboardSquare(gs.pieces[gs.turn][KING]);
+        if (squareToBitboard(king_square) & check_info.discovered_check_blockers) {
+            U64 king_moves = Bitboards::king_moves[king_square] & empty_spaces & ~pre_move_data.controlled_squares_unfriendly & ~genRayThrough(check_info.king_square, king_square);
+            while (king_moves) {
+                addMove(moves_c, moves_v, Move(king_square, getLeastBitboardSquare(king_moves), Move::PROMO::NONE, false));
+                king_moves &= king_moves - 1;
+            }
+        }
+
+        return moves_c;
+    }
+    static inline CheckInfo genCheckInfo(const GameState & gs) {
+        const COLOR color = gs.turn;
+        const int king_location = getLeastBitboardSquare(gs.pieces[!color][KING]); // assumes one king
+
+        CheckInfo output;
+        output.king_square = king_location;
+
+        // squares the enemy king "sees" are the squares a friendly piece would check from
+        output.check_squares[PAWN]   = Bitboards::pawn_attacks[king_location][!color];
+        output.check_squares[KNIGHT] = Bitboards::knight_moves[king_location];
+        output.check_squares[BISHOP] = genBishopRays(king_location, gs.occupied_spaces);
+        output.check_squares[ROOK]   = genRookRays(king_location, gs.occupied_spaces);
+        output.check_squares[QUEEN]  = output.check_squares[BISHOP] | output.check_squares[ROOK];
+        output.check_squares[KING]   = 0;
+
+        // discovered check blockers
+        output.discovered_check_blockers = 0;
+        U64 snipers = (Bitboards::bishop_moves[king_location] & (gs.pieces[color][BISHOP] | gs.pieces[color][QUEEN])) |
+                      (Bitboards::rook_moves[king_location] & (gs.pieces[color][ROOK] | gs.pieces[color][QUEEN]));
+        while (snipers) {
+            const U64 blockers_between = Bitboards::between[king_location][getLeastBitboardSquare(snipers)] & gs.occupied_spaces;
+            if (getBitboardPopulation(blockers_between) == 1 && (blockers_between & gs.occupied_spaces_color[color])) { // only one piece between the king and sniper, and it's a friendly piece
+                output.discovered_check_blockers |= blockers_between;
+            }
+            snipers &= snipers - 1;
+        }
+
+        return output;
+    }
+    static inline bool givesCheck(const GameState & gs, const CheckInfo & check_info, const Move & move) { // answers without applying the move, move must be legal
+        const int from = move.from();
+        const int to = move.to();
+        const PIECE starting_piece = gs.getPieceTypeAtSquare(from, gs.turn);
+        const U64 enemy_king_bitboard = squareToBitboard(check_info.king_square);
+
+        // en passant and castling move (or remove) a second piece, check the sliders against the resulting board
+        if (gs.isMoveEnPassant(move)) {
+            const int capture_square = to + (gs.turn == WHITE ? -8 : 8);
+            const U64 occupied_after = (gs.occupied_spaces ^ squareToBitboard(from) ^ squareToBitboard(capture_square)) | squareToBitboard(to);
+            return (check_info.check_squares[PAWN] & squareToBitboard(to)) ||
+                   (genBishopRays(check_info.king_square, occupied_after) & (gs.pieces[gs.turn][BISHOP] | gs.pieces[gs.turn][QUEEN])) ||
+                   (genRookRays(check_info.king_square, occupied_after) & (gs.pieces[gs.turn][ROOK] | gs.pieces[gs.turn][QUEEN]));
+        }
+        if (gs.isMoveCastle(move)) {
+            const bool kingside = from < to;
+            const int rook_from = kingside ? from + 3 : from - 4;
+            const int rook_to = kingside ? from + 1 : from - 1;
+            const U64 occupied_after = (gs.occupied_spaces ^ squareToBitboard(from) ^ squareToBitboard(rook_from)) | squareToBitboard(to) | squareToBitboard(rook_to);
+            const U64 rooks_after = (gs.pieces[gs.turn][ROOK] ^ squareToBitboard(rook_from)) | squareToBitboard(rook_to);
+            return (genBishopRays(check_info.king_square, occupied_after) & (gs.pieces[gs.turn][BISHOP] | gs.pieces[gs.turn][QUEEN])) ||
+                   (genRookRays(check_info.king_square, occupied_after) & (rooks_after | gs.pieces[gs.turn][QUEEN]));
+        }
+
+        // direct check
+        if (starting_piece == PAWN && move.promo_piece() != PAWN) { // promoted piece sees through the square the pawn left
+            if (Attacks::genPieceAttacks(to, gs.turn, move.promo_piece(), gs.occupied_spaces & ~squareToBitboard(from)) & enemy_king_bitboard) return true;
+        }
+        else if (check_info.check_squares[starting_piece] & squareToBitboard(to)) return true;
+
+        // discovered check, the blocker stepped off the line between the enemy king and a friendly slider
+        return (squareToBitboard(from) & check_info.discovered_check_blockers) && !(genRayThrough(check_info.king_square, from) & squareToBitboard(to));
+    }
+    static inline bool isPseudoLegal(const GameState & gs, const Move & move) { // true if move could have come from genAllMoves in this position, ignoring pins & checks (castling is fully checked) - for validating moves from outside the generator (tt, killers)
+        if (move.v == 0) return false;
+
+        const int from = move.from();
+        const int to = move.to();
+        const U64 from_bitboard = squareToBitboard(from);
+        const U64 to_bitboard = squareToBitboard(to);
+
+        if (!(gs.occupied_spaces_color[gs.turn] & from_bitboard)) return false; // must move a friendly piece
+        if (gs.occupied_spaces_color[gs.turn] & to_bitboard) return false; // can't land on a friendly piece
+
+        const PIECE piece_type = gs.getPieceTypeAtSquare(from, gs.turn);
+
+        if (piece_type == PAWN) {
+            const bool is_en_passant = gs.en_passant == to;
+            const bool is_promotion = to_bitboard & Bitboards::rows[gs.turn == WHITE ? 7 : 0];
+            if (is_promotion != (move.promo_piece() != PAWN)) return false;
+
+            if (move.isCapture()) return (Bitboards::pawn_attacks[from][gs.turn] & to_bitboard) && ((gs.occupied_spaces_color[!gs.turn] & to_bitboard) || is_en_passant);
+            if (Bitboards::pawn_pushes[from][gs.turn] & to_bitboard & ~gs.occupied_spaces) return true;
+            return (Bitboards::pawn_double_pushes[from][gs.turn] & to_bitboard & ~gs.occupied_spaces) && (Bitboards::pawn_pushes[from][gs.turn] & ~gs.occupied_spaces);
+        }
+
+        if (move.promo_piece() != PAWN) return false; // only pawns promote
+        if (move.isCapture() != bool(gs.occupied_spaces_color[!gs.turn] & to_bitboard)) return false; // capture flag must match the board
+
+        switch (piece_type) {
+            case KNIGHT: return Bitboards::knight_moves[from] & to_bitboard;
+            case BISHOP: return genBishopRays(from, gs.occupied_spaces) & to_bitboard;
+            case ROOK:   return genRookRays(from, gs.occupied_spaces) & to_bitboard;
+            case QUEEN:  return (genBishopRays(from, gs.occupied_spaces) | genRookRays(from, gs.occupied_spaces)) & to_bitboard;
+            case KING:
+                if (Bitboards::king_moves[from] & to_bitboard) return true;
+                if (from != (gs.turn == WHITE ? 4 : 60)) return false;
+                if (to == from + 2) return canCastleKingside(gs, genControlledSquares(gs, (COLOR) !gs.turn));
+                if (to == from - 2) return canCastleQueenside(gs, genControlledSquares(gs, (COLOR) !gs.turn));
+                return false;
+            default: return false;
+        }
+    }
+    static inline bool isLegal(const GameState & gs, const Move & move, const PreMoveData & pre_move_data) { // for a pseudo legal move, true if it doesn't leave the friendly king in check
+        const int from = move.from();
+        const int to = move.to();
+        const U64 to_bitboard = squareToBitboard(to);
+
+        if (gs.pieces[gs.turn][KING] & squareToBitboard(from)) {
+            if (std::abs(from - to) == 2) return true; // castling is fully checked by isPseudoLegal
+            return !(pre_move_data.controlled_squares_unfriendly & to_bitboard);
+        }
+
+        const CheckData & enemy_checks = pre_move_data.check_data;
+        const PinData & enemy_pins = pre_move_data.pin_data;
+        const bool is_en_passant = gs.isMoveEnPassant(move);
+
+        if (enemy_checks.is_double_check) return false;
+        if (enemy_checks.checkers_bitboard) {
+            const bool captures_checker = is_en_passant && (squareToBitboard(to + (gs.turn == WHITE ? -8 : 8)) & enemy_checks.checkers_bitboard);
+            if (!(enemy_checks.evasion_bitboard & to_bitboard) && !captures_checker) return false;
+        }
+        if ((enemy_pins.pins & squareToBitboard(from)) && !(enemy_pins.allowed_moves[from] & to_bitboard)) return false;
+        if (is_en_passant) return isEnPassantLegal(gs, from);
+        return true;
+    }
+    static inline PreMoveData genPreMoveData(const GameState & gs, bool gen_pin_data = true) { // pin data is not needed for genPseudoLegalMoves
         return PreMoveData {
             genControlledSquares(gs, gs.turn),
             genControlledSquares(gs, (COLOR) !gs.turn),
             genCheckData(gs, gs.turn),
-            genPinData(gs, gs.turn)
+            gen_pin_data ? genPinData(gs, gs.turn) : PinData()
         };
     }
 
 private:
     // bishop and rook rays
-    // TODO: optimization - replace generation with magic bitboards
     static inline U64 genBishopRays(int position, U64 occupied_spaces) {
-        const int index = (((occupied_spaces & MagicBitboards::bishop_magic_relevant_squares_mask[position]) * MagicBitboards::bishop_magic_numbers[position]) >> (64 - MagicBitboards::bishop_magic_relevant_bits_count[position]));
-        return MagicBitboards::bishop_magic_bitboards[position][index];
+        return Attacks::genBishopRays(position, occupied_spaces);
     }
     static inline U64 genRookRays(int position, U64 occupied_spaces) {
-        const int index = (((occupied_spaces & MagicBitboards::rook_magic_relevant_squares_mask[position]) * MagicBitboards::rook_magic_numbers[position]) >> (64 - MagicBitboards::rook_magic_relevant_bits_count[position]));
-        return MagicBitboards::rook_magic_bitboards[position][index];
+        return Attacks::genRookRays(position, occupied_spaces);
+    }
+    
+    static inline U64 genRayThrough(int origin, int square) { // the single ray from origin that passes through square, 0 if not aligned
+        for (int d = 0; d < 4; ++d) {
+            if (Bitboards::rook_rays[origin][d] & squareToBitboard(square)) return Bitboards::rook_rays[origin][d];
+            if (Bitboards::bishop_rays[origin][d] & squareToBitboard(square)) return Bitboards::bishop_rays[origin][d];
+        }
+        return 0;
     }
     
     static inline U64 genControlledSquares(const GameState & gs, COLOR color) {
@@ -200,19 +436,63 @@ private:
         return output;
     }
 
+    static inline bool isEnPassantLegal(const GameState & gs, int pawn_search_square) { // pins & checks aside, en passant removes two pawns from the row, which can expose the king horizontally
+        if (!(Bitboards::rows[gs.turn == WHITE ? 4 : 3] & gs.pieces[gs.turn][KING])) return true; // if the same row does not contain the friendly king
+
+        U64 occupied_spaces_substitute = gs.occupied_spaces;
+        occupied_spaces_substitute ^= squareToBitboard(pawn_search_square) | squareToBitboard(gs.en_passant + (gs.turn == WHITE ? -8 : 8)); // remove theoritical pawn move & capture square
+        
+        const int king_location = getLeastBitboardSquare(gs.pieces[gs.turn][KING]); // assumes one king
+        for (int d = 2; d < 4; ++d) {
+            U64 ray = Bitboards::rook_rays[king_location][d]; // (N, S,) E, W
+            U64 blockers = ray & occupied_spaces_substitute;
+
+            if (blockers) {
+                int blocker_square = (d % 2 == 0) ? getLeastBitboardSquare(blockers) : getMostBitboardSquare(blockers);
+                if (squareToBitboard(blocker_square) & (gs.pieces[!gs.turn][ROOK] | gs.pieces[!gs.turn][QUEEN])) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    static constexpr U64 castle_K_clear_squares = Bitboards::between[4][7]; // f1, g1
+    static constexpr U64 castle_K_no_check_squares = Bitboards::between[3][7]; // e1, f1, g1
+
+    static constexpr U64 castle_Q_clear_squares = Bitboards::between[0][4]; // b1, c1, d1
+    static constexpr U64 castle_Q_no_check_squares = Bitboards::between[1][5]; // c1, d1, e1
+
+    static constexpr U64 castle_k_clear_squares = Bitboards::between[60][63]; // f8, g8
+    static constexpr U64 castle_k_no_check_squares = Bitboards::between[59][63]; // e8, f8, g8
+
+    static constexpr U64 castle_q_clear_squares = Bitboards::between[56][60]; // b8, c8, d8
+    static constexpr U64 castle_q_no_check_squares = Bitboards::between[57][61]; // c8, d8, e8
+
+    static inline bool canCastleKingside(const GameState & gs, const U64 enemy_controlled_squares) {
+        return (gs.turn == WHITE ? gs.castle_K : gs.castle_k) &&
+               (((gs.turn == WHITE ? castle_K_clear_squares : castle_k_clear_squares) & gs.occupied_spaces) == 0) &&
+               (((gs.turn == WHITE ? castle_K_no_check_squares : castle_k_no_check_squares) & enemy_controlled_squares) == 0);
+    }
+    static inline bool canCastleQueenside(const GameState & gs, const U64 enemy_controlled_squares) {
+        return (gs.turn == WHITE ? gs.castle_Q : gs.castle_q) &&
+               (((gs.turn == WHITE ? castle_Q_clear_squares : castle_q_clear_squares) & gs.occupied_spaces) == 0) &&
+               (((gs.turn == WHITE ? castle_Q_no_check_squares : castle_q_no_check_squares) & enemy_controlled_squares) == 0);
+    }
+
 private:
     static inline void addMove(unsigned int & moves_c, Move * moves_v, const Move && move) {
         moves_v[moves_c] = move;
         moves_c++;
     }
 
-    static inline void genPawns(const GameState & gs, unsigned int & moves_c, Move * moves_v, const U64 check_evasion_bitboard, const PinData & pin_data, bool gen_only_captures) {
+    static inline void genPawns(const GameState & gs, unsigned int & moves_c, Move * moves_v, const U64 check_evasion_bitboard, const PinData & pin_data, GEN_TYPE gen_type) {
         U64 pawn_bitboard = gs.pieces[gs.turn][PAWN];
         while (pawn_bitboard) {
             const int pawn_search_square = getLeastBitboardSquare(pawn_bitboard); // for each pawn of gs.turn color
             const bool is_pinned = squareToBitboard(pawn_search_square) & pin_data.pins; // pins
             
-            if (!gen_only_captures) {
+            if (gen_type != CAPTURES) {
                 U64 pawn_pushes = Bitboards::pawn_pushes[pawn_search_square][gs.turn] & ~gs.occupied_spaces;
                 if (pawn_pushes) pawn_pushes |= Bitboards::pawn_double_pushes[pawn_search_square][gs.turn] & ~gs.occupied_spaces;
                 pawn_pushes &= check_evasion_bitboard;
@@ -239,6 +519,7 @@ private:
             U64 pawn_captures = Bitboards::pawn_attacks[pawn_search_square][gs.turn] & ((gs.occupied_spaces_color[!gs.turn] | en_passant_square) & (check_evasion_bitboard));
             if ((en_passant_capture_square & check_evasion_bitboard) && (Bitboards::pawn_attacks[pawn_search_square][gs.turn] & en_passant_square)) pawn_captures |= en_passant_square; // taking en passant after the double pawn push never results in a block (from rook or bishop), so this is okay
             if (is_pinned) pawn_captures &= pin_data.allowed_moves[pawn_search_square]; // pins
+            if (gen_type == QUIETS) pawn_captures = 0;
 
             while (pawn_captures) {
                 const int pawn_capture_square = getLeastBitboardSquare(pawn_captures);
@@ -250,26 +531,8 @@ private:
                     addMove(moves_c, moves_v, Move(pawn_search_square, pawn_capture_square, Move::PROMO::QUEEN, true));
                 }
                 else {
-                    if (is_en_passant && (Bitboards::rows[gs.turn == WHITE ? 4 : 3] & gs.pieces[gs.turn][KING])) { // if enpassant and the same row contains the friendly king
-                        bool is_legal = true;
-
-                        U64 occupied_spaces_substitute = gs.occupied_spaces;
-                        occupied_spaces_substitute ^= squareToBitboard(pawn_search_square) | squareToBitboard(pawn_capture_square + (gs.turn == WHITE ? -8 : 8)); // remove theoritical pawn move & capture square
-                        
-                        const int king_location = getLeastBitboardSquare(gs.pieces[gs.turn][KING]); // assumes one king
-                        for (int d = 2; d < 4; ++d) {
-                            U64 ray = Bitboards::rook_rays[king_location][d]; // (N, S,) E, W
-                            U64 blockers = ray & occupied_spaces_substitute;
-
-                            if (blockers) {
-                                int blocker_square = (d % 2 == 0) ? getLeastBitboardSquare(blockers) : getMostBitboardSquare(blockers);
-                                if (squareToBitboard(blocker_square) & (gs.pieces[!gs.turn][ROOK] | gs.pieces[!gs.turn][QUEEN])) {
-                                    is_legal = false;
-                                    break;
-                                }
-                            }
-                        }
-                        if (is_legal) addMove(moves_c, moves_v, Move(pawn_search_square, pawn_capture_square, Move::PROMO::NONE, true));
+                    if (is_en_passant) {
+                        if (isEnPassantLegal(gs, pawn_search_square)) addMove(moves_c, moves_v, Move(pawn_search_square, pawn_capture_square, Move::PROMO::NONE, true));
                     } else {
                         addMove(moves_c, moves_v, Move(pawn_search_square, pawn_capture_square, Move::PROMO::NONE, true));
                     }
@@ -281,14 +544,14 @@ private:
             pawn_bitboard &= pawn_bitboard - 1; // remove rightmost 1 bit
         }
     }
-    static inline void genKnights(const GameState & gs, unsigned int & moves_c, Move * moves_v, const U64 check_evasion_bitboard, const PinData & pin_data, bool gen_only_captures) {
+    static inline void genKnights(const GameState & gs, unsigned int & moves_c, Move * moves_v, const U64 check_evasion_bitboard, const PinData & pin_data, GEN_TYPE gen_type) {
         U64 knight_bitboard = gs.pieces[gs.turn][KNIGHT];
         while (knight_bitboard) {
             const int knight_search_square = getLeastBitboardSquare(knight_bitboard); // for each pawn of gs.turn color
             const bool is_pinned = squareToBitboard(knight_search_square) & pin_data.pins; // pins
             
             
-            if (!gen_only_captures) {
+            if (gen_type != CAPTURES) {
                 U64 knight_moves = Bitboards::knight_moves[knight_search_square] & ~gs.occupied_spaces & check_evasion_bitboard;
                 if (is_pinned) knight_moves &= pin_data.allowed_moves[knight_search_square];
                 while (knight_moves) {
@@ -299,6 +562,7 @@ private:
 
             U64 knight_captures = Bitboards::knight_moves[knight_search_square] & gs.occupied_spaces_color[!gs.turn] & check_evasion_bitboard;
             if (is_pinned) knight_captures &= pin_data.allowed_moves[knight_search_square];
+            if (gen_type == QUIETS) knight_captures = 0;
             while (knight_captures) {
                 const int knight_capture_square = getLeastBitboardSquare(knight_captures);
                 addMove(moves_c, moves_v, Move(knight_search_square, knight_capture_square, Move::PROMO::NONE, true));
@@ -307,14 +571,14 @@ private:
             knight_bitboard &= knight_bitboard - 1;
         }
     }
-    static inline void genBishops(const GameState & gs, unsigned int & moves_c, Move * moves_v, const U64 check_evasion_bitboard, const PinData & pin_data, bool gen_only_captures) {
+    static inline void genBishops(const GameState & gs, unsigned int & moves_c, Move * moves_v, const U64 check_evasion_bitboard, const PinData & pin_data, GEN_TYPE gen_type) {
         U64 bishop_bitboard = gs.pieces[gs.turn][BISHOP];
         while (bishop_bitboard) {
             const int bishop_search_square = getLeastBitboardSquare(bishop_bitboard); // for each pawn of gs.turn color
             const bool is_pinned = squareToBitboard(bishop_search_square) & pin_data.pins; // pins
             const U64 bishop_controlled_squares = genBishopRays(bishop_search_square, gs.occupied_spaces);
             
-            if (!gen_only_captures) {
+            if (gen_type != CAPTURES) {
                 U64 bishop_moves = bishop_controlled_squares & ~gs.occupied_spaces & check_evasion_bitboard;
                 if (is_pinned) bishop_moves &= pin_data.allowed_moves[bishop_search_square];
                 while (bishop_moves) {
@@ -325,6 +589,7 @@ private:
 
             U64 bishop_captures = bishop_controlled_squares & gs.occupied_spaces_color[!gs.turn] & check_evasion_bitboard;
             if (is_pinned) bishop_captures &= pin_data.allowed_moves[bishop_search_square];
+            if (gen_type == QUIETS) bishop_captures = 0;
             while (bishop_captures) {
                 const int bishop_capture_square = getLeastBitboardSquare(bishop_captures);
                 addMove(moves_c, moves_v, Move(bishop_search_square, bishop_capture_square, Move::PROMO::NONE, true));
@@ -333,26 +598,25 @@ private:
             bishop_bitboard &= bishop_bitboard - 1;
         }
     }
-    static inline void genRooks(const GameState & gs, unsigned int & moves_c, Move * moves_v, const U64 check_evasion_bitboard, const PinData & pin_data, bool gen_only_captures) {
+    static inline void genRooks(const GameState & gs, unsigned int & moves_c, Move * moves_v, const U64 check_evasion_bitboard, const PinData & pin_data, GEN_TYPE gen_type) {
         U64 rook_bitboard = gs.pieces[gs.turn][ROOK];
         while (rook_bitboard) {
             const int rook_search_square = getLeastBitboardSquare(rook_bitboard); // for each pawn of gs.turn color
             const bool is_pinned = squareToBitboard(rook_search_square) & pin_data.pins; // pins
             const U64 rook_controlled_squares = genRookRays(rook_search_square, gs.occupied_spaces);
             
-            if (!gen_only_captures) {
-                if (!gen_only_captures) {
-                    U64 rook_moves = rook_controlled_squares & ~gs.occupied_spaces & check_evasion_bitboard;
-                    if (is_pinned) rook_moves &= pin_data.allowed_moves[rook_search_square];
-                    while (rook_moves) {
-                        addMove(moves_c, moves_v, Move(rook_search_square, getLeastBitboardSquare(rook_moves), Move::PROMO::NONE, false));
-                        rook_moves &= rook_moves - 1;
-                    }
+            if (gen_type != CAPTURES) {
+                U64 rook_moves = rook_controlled_squares & ~gs.occupied_spaces & check_evasion_bitboard;
+                if (is_pinned) rook_moves &= pin_data.allowed_moves[rook_search_square];
+                while (rook_moves) {
+                    addMove(moves_c, moves_v, Move(rook_search_square, getLeastBitboardSquare(rook_moves), Move::PROMO::NONE, false));
+                    rook_moves &= rook_moves - 1;
                 }
             }
 
             U64 rook_captures = rook_controlled_squares & gs.occupied_spaces_color[!gs.turn] & check_evasion_bitboard;
             if (is_pinned) rook_captures &= pin_data.allowed_moves[rook_search_square];
+            if (gen_type == QUIETS) rook_captures = 0;
             while (rook_captures) {
                 const int rook_capture_square = getLeastBitboardSquare(rook_captures);
                 addMove(moves_c, moves_v, Move(rook_search_square, rook_capture_square, Move::PROMO::NONE, true));
@@ -361,14 +625,14 @@ private:
             rook_bitboard &= rook_bitboard - 1;
         }
     }
-    static inline void genQueens(const GameState & gs, unsigned int & moves_c, Move * moves_v, const U64 check_evasion_bitboard, const PinData & pin_data, bool gen_only_captures) {
+    static inline void genQueens(const GameState & gs, unsigned int & moves_c, Move * moves_v, const U64 check_evasion_bitboard, const PinData & pin_data, GEN_TYPE gen_type) {
         U64 queen_bitboard = gs.pieces[gs.turn][QUEEN];
         while (queen_bitboard) {
             const int queen_search_square = getLeastBitboardSquare(queen_bitboard); // for each pawn of gs.turn color
             const bool is_pinned = squareToBitboard(queen_search_square) & pin_data.pins; // pins
             const U64 queen_controlled_squares = genBishopRays(queen_search_square, gs.occupied_spaces) | genRookRays(queen_search_square, gs.occupied_spaces);
             
-            if (!gen_only_captures) {
+            if (gen_type != CAPTURES) {
                 U64 queen_moves = queen_controlled_squares & ~gs.occupied_spaces & check_evasion_bitboard;
                 if (is_pinned) queen_moves &= pin_data.allowed_moves[queen_search_square];
                 while (queen_moves) {
@@ -379,6 +643,7 @@ private:
 
             U64 queen_captures = queen_controlled_squares & gs.occupied_spaces_color[!gs.turn] & check_evasion_bitboard;
             if (is_pinned) queen_captures &= pin_data.allowed_moves[queen_search_square];
+            if (gen_type == QUIETS) queen_captures = 0;
             while (queen_captures) {
                 const int queen_capture_square = getLeastBitboardSquare(queen_captures);
                 addMove(moves_c, moves_v, Move(queen_search_square, queen_capture_square, Move::PROMO::NONE, true));
@@ -387,10 +652,10 @@ private:
             queen_bitboard &= queen_bitboard - 1;
         }
     }
-    static inline void genKing(const GameState & gs, unsigned int & moves_c, Move * moves_v, const U64 enemy_controlled_squares, bool gen_only_captures) {
+    static inline void genKing(const GameState & gs, unsigned int & moves_c, Move * moves_v, const U64 enemy_controlled_squares, GEN_TYPE gen_type) {
         const int king_square = getLeastBitboardSquare(gs.pieces[gs.turn][KING]);
 
-        if (!gen_only_captures) {
+        if (gen_type != CAPTURES) {
             U64 king_moves = Bitboards::king_moves[king_square] & ~gs.occupied_spaces & ~enemy_controlled_squares;
             while (king_moves) {
                 addMove(moves_c, moves_v, Move(king_square, getLeastBitboardSquare(king_moves), Move::PROMO::NONE, false));
@@ -399,40 +664,86 @@ private:
         }
 
         U64 king_captures = Bitboards::king_moves[king_square] & gs.occupied_spaces_color[!gs.turn] & ~enemy_controlled_squares;
+        if (gen_type == QUIETS) king_captures = 0;
         while (king_captures) {
             const int king_capture_square = getLeastBitboardSquare(king_captures);
             addMove(moves_c, moves_v, Move(king_square, king_capture_square, Move::PROMO::NONE, true));
             king_captures &= king_captures - 1;
         }
 
-        if (!gen_only_captures) {
-            constexpr U64 castle_K_clear_squares = Bitboards::between[4][7]; // f1, g1
-            constexpr U64 castle_K_no_check_squares = Bitboards::between[3][7]; // e1, f1, g1
-
-            constexpr U64 castle_Q_clear_squares = Bitboards::between[0][4]; // b1, c1, d1
-            constexpr U64 castle_Q_no_check_squares = Bitboards::between[1][5]; // c1, d1, e1
+        if (gen_type != CAPTURES) {
+            if (canCastleKingside(gs, enemy_controlled_squares)) addMove(moves_c, moves_v, Move(king_square, king_square + 2, Move::PROMO::NONE, false));
+            if (canCastleQueenside(gs, enemy_controlled_squares)) addMove(moves_c, moves_v, Move(king_square, king_square - 2, Move::PROMO::NONE, false));
+        }
+   
+    }
 
-            constexpr U64 castle_k_clear_squares = Bitboards::between[60][63]; // f8, g8
-            constexpr U64 castle_k_no_check_squares = Bitboards::between[59][63]; // e8, f8, g8
+private:
+    // count only variants of the generators above, popcount the legal target set of each piece
+    static inline unsigned int countPawns(const GameState & gs, const U64 check_evasion_bitboard, const PinData & pin_data) {
+        unsigned int moves_c = 0;
 
-            constexpr U64 castle_q_clear_squares = Bitboards::between[56][60]; // b8, c8, d8
-            constexpr U64 castle_q_no_check_squares = Bitboards::between[57][61]; // c8, d8, e8
+        const U64 promotion_from_row = Bitboards::rows[gs.turn == WHITE ? 6 : 1];
+        const U64 en_passant_square = (gs.en_passant != -1) ? squareToBitboard(gs.en_passant) : 0;
+        const bool en_passant_evades = (gs.en_passant != -1) && (squareToBitboard(gs.en_passant + (gs.turn == WHITE ? -8 : 8)) & check_evasion_bitboard);
 
-            // castling kingside
-            if ((gs.turn == WHITE ? gs.castle_K : gs.castle_k) &&
-                (((gs.turn == WHITE ? castle_K_clear_squares : castle_k_clear_squares) & gs.occupied_spaces) == 0) &&
-                (((gs.turn == WHITE ? castle_K_no_check_squares : castle_k_no_check_squares) & enemy_controlled_squares) == 0)) {
-                    addMove(moves_c, moves_v, Move(king_square, king_square + 2, Move::PROMO::NONE, false));
+        U64 pawn_bitboard = gs.pieces[gs.turn][PAWN];
+        while (pawn_bitboard) {
+            const int pawn_search_square = getLeastBitboardSquare(pawn_bitboard);
+            const bool is_pinned = squareToBitboard(pawn_search_square) & pin_data.pins;
+
+            U64 pawn_pushes = Bitboards::pawn_pushes[pawn_search_square][gs.turn] & ~gs.occupied_spaces;
+            if (pawn_pushes) pawn_pushes |= Bitboards::pawn_double_pushes[pawn_search_square][gs.turn] & ~gs.occupied_spaces;
+            U64 pawn_captures = Bitboards::pawn_attacks[pawn_search_square][gs.turn] & gs.occupied_spaces_color[!gs.turn];
+            U64 pawn_targets = (pawn_pushes | pawn_captures) & check_evasion_bitboard;
+            if (is_pinned) pawn_targets &= pin_data.allowed_moves[pawn_search_square];
+
+            if (squareToBitboard(pawn_search_square) & promotion_from_row) moves_c += 4 * getBitboardPopulation(pawn_targets); // every target is a promotion
+            else                                                           moves_c += getBitboardPopulation(pawn_targets);
+
+            // en passant
+            if ((Bitboards::pawn_attacks[pawn_search_square][gs.turn] & en_passant_square) && 
+                (en_passant_evades || (en_passant_square & check_evasion_bitboard)) &&
+                (!is_pinned || (pin_data.allowed_moves[pawn_search_square] & en_passant_square)) &&
+                isEnPassantLegal(gs, pawn_search_square)) {
+                    moves_c++;
             }
+            pawn_bitboard &= pawn_bitboard - 1;
+        }
 
-            // castling queenside
-            if ((gs.turn == WHITE ? gs.castle_Q : gs.castle_q) &&
-                (((gs.turn == WHITE ? castle_Q_clear_squares : castle_q_clear_squares) & gs.occupied_spaces) == 0) &&
-                (((gs.turn == WHITE ? castle_Q_no_check_squares : castle_q_no_check_squares) & enemy_controlled_squares) == 0)) {
-                    addMove(moves_c, moves_v, Move(king_square, king_square - 2, Move::PROMO::NONE, false));
+        return moves_c;
+    }
+    static inline unsigned int countPieces(const GameState & gs, const U64 check_evasion_bitboard, const PinData & pin_data) { // knights, bishops, rooks & queens
+        unsigned int moves_c = 0;
+
+        const U64 target_mask = ~gs.occupied_spaces_color[gs.turn] & check_evasion_bitboard;
+        for (int piece_type = KNIGHT; piece_type <= QUEEN; piece_type++) {
+            U64 bb = gs.pieces[gs.turn][piece_type];
+            while (bb) {
+                const int from = getLeastBitboardSquare(bb);
+
+                U64 targets = 0;
+                switch (piece_type) {
+                    case KNIGHT: targets = Bitboards::knight_moves[from]; break;
+                    case BISHOP: targets = genBishopRays(from, gs.occupied_spaces); break;
+                    case ROOK:   targets = genRookRays(from, gs.occupied_spaces); break;
+                    case QUEEN:  targets = genBishopRays(from, gs.occupied_spaces) | genRookRays(from, gs.occupied_spaces); break;
+                }
+                targets &= target_mask;
+                if (squareToBitboard(from) & pin_data.pins) targets &= pin_data.allowed_moves[from];
+
+                moves_c += getBitboardPopulation(targets);
+                bb &= bb - 1;
             }
         }
-   
+
+        return moves_c;
+    }
+    static inline unsigned int countKing(const GameState & gs, const U64 enemy_controlled_squares) {
+        const int king_square = getLeastBitboardSquare(gs.pieces[gs.turn][KING]);
+        return getBitboardPopulation(Bitboards::king_moves[king_square] & ~gs.occupied_spaces_color[gs.turn] & ~enemy_controlled_squares) +
+               canCastleKingside(gs, enemy_controlled_squares) +
+               canCastleQueenside(gs, enemy_controlled_squares);
     }
 
 
@@ -26,7 +26,7 @@ struct Unmove {
     COLOR turn_before;
     U64 hash_before;
 
-    Unmove(int _from, int _to, PIECE _starting_piece, PIECE _ending_piece, CAPTURE _captured_piece, bool _is_en_passant, bool _is_castle, bool pre_castle_K, bool pre_castle_Q, bool pre_castle_k, bool pre_castle_q, int pre_en_passant, bool pre_halfmove_clock, bool pre_fullmove_clock, COLOR pre_turn, U64 pre_hash_code):
+    Unmove(int _from, int _to, PIECE _starting_piece, PIECE _ending_piece, CAPTURE _captured_piece, bool _is_en_passant, bool _is_castle, bool pre_castle_K, bool pre_castle_Q, bool pre_castle_k, bool pre_castle_q, int pre_en_passant, unsigned int pre_halfmove_clock, unsigned int pre_fullmove_clock, COLOR pre_turn, U64 pre_hash_code):
         from(_from),
         to(_to),
         starting_piece(_starting_piece),
@@ -0,0 +1,85 @@
+#include <logger/logger.hpp>
+
+#include <chrono>
+
+#include <lib/chess/gamestate.hpp>
+#include <lib/chess/fen.hpp>
+
+#include <lib/chess/engine/engine.hpp>
+
+// fixed bench set, every search starts with a fresh engine (empty tt) so runs are comparable
+static const char * bench_positions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r3k1r1/ppp2p1p/1qn5/1B1p1b2/1P3B1p/P1NP1P2/2P1N2P/R2QK2R w KQq - 1 15",
+    "3r1rk1/ppqn1ppp/2p1p3/2P5/2BP4/P2Q1P1P/5PP1/3RR1K1 b - - 4 18",
+};
+
+struct BenchResult {
+    long long nodes;
+    double ms;
+};
+
+BenchResult runBench(int depth) {
+    static constexpr Logger logger = Logger("BENCH");
+
+    BenchResult total = {0, 0};
+    for (const char * fen : bench_positions) {
+        Chess::Engine::Negamax::qcnt = 0;
+        Chess::Engine::Negamax::ncnt = 0;
+
+        Chess::Engine::Engine engine = Chess::Engine::Engine();
+        Chess::GameState gs = Chess::FEN::FENToGameState(fen);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        auto results = engine.evaluateAllMoves(gs, depth);
+        auto finish = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> elapsed = finish - start;
+
+        const long long nodes = (long long) Chess::Engine::Negamax::qcnt + Chess::Engine::Negamax::ncnt;
+        logger << fen << " | best: " << (results.empty() ? "none" : results[0].move.toString()) << " | nodes: " << nodes << " | " << elapsed.count() << "ms";
+
+        total.nodes += nodes;
+        total.ms += elapsed.count();
+    }
+    return total;
+}
+
+int main(int argc, char* argv[]) {
+    static constexpr Logger logger = Logger("MAIN");
+
+    if(argc != 2) {
+        logger.log(Logger::WARNING) << "Please provide an int argument for depth";
+        return 0;
+    }
+    char *p;
+    errno = 0;
+    long depth = strtol(argv[1], &p, 10);
+
+    if (errno != 0 || *p != '\0' || depth > 100 || depth < 1) {
+        logger.log(Logger::WARNING) << "Please provide an int argument for depth (1 - 100)";
+        return 0;
+    } 
+
+    using Chess::Engine::Negamax::GenerationMode;
+    const std::pair<GenerationMode, const char *> modes[] = {
+        {GenerationMode::LEGAL, "legal"},
+        {GenerationMode::PSEUDO_LEGAL, "pseudo legal"},
+    };
+
+    for (const auto & [mode, name] : modes) {
+        Chess::Engine::Negamax::generation_mode = mode;
+        logger << "--- " << name << " move generation, depth " << depth << " ---";
+
+        BenchResult result = runBench(depth);
+        logger << "total nodes: " << result.nodes;
+        logger << "time to depth: " << result.ms << "ms";
+        logger << "nodes/sec: " << (long long) (result.nodes / (result.ms / 1000.0));
+    }
+
+    return 0;
+}
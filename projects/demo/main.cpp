@@ -80,7 +80,7 @@ void run_command(const std::string & command) {
 
         auto start = std::chrono::high_resolution_clock::now();
 
-        auto results = engine.evaluateAllMoves(game.getGameState(), engine_depth);
+        auto results = engine.evaluateAllMoves(game.getGameState(), engine_depth, game.getKeyHistory());
 
         auto finish = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double, std::milli> elapsed = finish - start;
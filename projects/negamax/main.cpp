@@ -41,6 +41,10 @@ int main(int argc, char* argv[]) {
         logger << result.move.toString() << " -> " << result.score;
     }
 
+    std::string pv;
+    for (const Chess::Move & move : engine.getPrincipalVariation()) pv += move.toString() + ", ";
+    logger << "pv: " << pv;
+
     logger << "in: " << elapsed.count() << "ms";
 
     logger << "qcnt:  " << Chess::Engine::Negamax::qcnt;
@@ -48,6 +52,8 @@ int main(int argc, char* argv[]) {
     logger << "tthit: " << Chess::Engine::Negamax::tthit << " (" << (int) (((float) Chess::Engine::Negamax::tthit / (Chess::Engine::Negamax::qcnt + Chess::Engine::Negamax::ncnt)) * 10000) / 100.0f << "%)";
     logger << "ttoff: " << Chess::Engine::Negamax::ttcut << " (" << (int) (((float) Chess::Engine::Negamax::ttcut / (Chess::Engine::Negamax::qcnt + Chess::Engine::Negamax::ncnt)) * 10000) / 100.0f << "%)";
 
+    logger << "first move cutoffs: " << Chess::Engine::Negamax::firstcut << " / " << Chess::Engine::Negamax::betacut << " (" << (int) (((float) Chess::Engine::Negamax::firstcut / Chess::Engine::Negamax::betacut) * 10000) / 100.0f << "%)";
+
     logger << "popcnt cnt: " << Chess::popcnt_callcnt;
 
     return 0;